@@ -1,6 +1,8 @@
 #pragma once
 
 #include "JuceHeader.h"
+#include "CurveEvaluator.h"
+#include "TelemetrySlot.h"
 
 namespace ce {
   template<typename T>
@@ -16,6 +18,14 @@ namespace ce {
 
     static constexpr int CurveTypeCount = 3;
 
+    // one entry per 7-bit input, and optionally one per 14-bit input, spread evenly over [minX, maxX]
+    static constexpr int TableSize = 128;
+    static constexpr int FineTableSize = 16384;
+
+    // tables live on the heap to keep the model movable
+    using Table = CurveTable<T, TableSize>;
+    using FineTable = CurveTable<T, FineTableSize>;
+
     struct Handle;
 
     struct Node {
@@ -72,12 +82,14 @@ namespace ce {
       //void setY(T newY) { pt.setY(newY); }
     };
 
-    explicit CurveEditorModel(T _minX, T _maxX, T _minY, T _maxY) :
+    explicit CurveEditorModel(T _minX, T _maxX, T _minY, T _maxY, bool withFineTable = false) :
       minX(_minX),
       maxX(_maxX),
       minY(_minY),
       maxY(_maxY),
-      lastInputValue(static_cast<T> (0)) {
+      lastInput(std::make_unique<TelemetrySlot<T>>(static_cast<T> (0))),
+      table(std::make_unique<Table>()),
+      fineTable(withFineTable ? std::make_unique<FineTable>() : nullptr) {
       nodes.clear();
       nodes.emplace_back(std::make_shared<Node>(PointType{minX, minY}));
       nodes.emplace_back(std::make_shared<Node>(PointType{
@@ -85,6 +97,7 @@ namespace ce {
         minY + (maxY - minY) * static_cast<T> (0.5)
       }));
       nodes.emplace_back(std::make_shared<Node>(PointType{maxX, maxY}));
+      bake();
     }
 
     void fromValueTree(const juce::ValueTree &tree) {
@@ -101,9 +114,51 @@ namespace ce {
           node->setControlPt2(PointType{control2.getProperty("x"), control2.getProperty("y")});
           nodes.push_back(node);
         }
+        bake();
+      }
+    }
+
+    /**
+     * Rebuild the lookup table from the current nodes, must be called after every edit
+     */
+    void bake() {
+      auto snapshot = evaluator();
+      table->bake(snapshot, minX, maxX);
+      if (fineTable != nullptr) {
+        fineTable->bake(snapshot, minX, maxX);
       }
     }
 
+    /**
+     * A flat snapshot of the current curve, for exact or batch evaluation
+     */
+    [[nodiscard]] CurveEvaluator<T> evaluator() const {
+      CurveEvaluator<T> result;
+      for (size_t i = 1; i < nodes.size(); i++) {
+        result.addSegment(coefficients(*nodes[i - 1], *nodes[i]));
+      }
+      return result;
+    }
+
+    /**
+     * Map a 7-bit input onto the curve, lock-free and allocation free
+     */
+    [[nodiscard]] T lookup(int input) const {
+      return table->lookup(input);
+    }
+
+    /**
+     * Map a 14-bit input onto the curve, the model must have been created with the fine table
+     */
+    [[nodiscard]] T lookupFine(int input) const {
+      jassert (fineTable != nullptr);
+      return fineTable->lookup(input);
+    }
+
+    [[nodiscard]] std::uint32_t getVersion() const {
+      return table->version.load(std::memory_order_acquire);
+    }
+
     /**
      * Map an input value onto the curve
      */
@@ -112,7 +167,23 @@ namespace ce {
     T minX, maxX;
     T minY, maxY;
     std::vector<std::shared_ptr<Node>> nodes;
-    juce::Value lastInputValue;
+    // the most recent input seen by the processor, written from the audio thread
+    std::unique_ptr<TelemetrySlot<T>> lastInput;
+    std::unique_ptr<Table> table;
+    std::unique_ptr<FineTable> fineTable;
+
+  private:
+    static typename CurveEvaluator<T>::Coefficients coefficients(const Node &from, const Node &to) {
+      switch (from.curveType) {
+        case CurveType::Cubic:
+          return CurveEvaluator<T>::makeCubic(from.anchor.pt, from.control1.pt, from.control2.pt, to.anchor.pt);
+        case CurveType::Quadratic:
+          return CurveEvaluator<T>::makeQuadratic(from.anchor.pt, from.control1.pt, to.anchor.pt);
+        default:
+        case CurveType::Linear:
+          return CurveEvaluator<T>::makeLinear(from.anchor.pt, to.anchor.pt);
+      }
+    }
   };
 
   template<typename T>
@@ -122,60 +193,10 @@ namespace ce {
       const auto &lastNode = *nodes[i - 1];
       const auto &node = *nodes[i];
 
-      const auto &lastAnchorPoint = lastNode.anchor.pt;
-      const auto &anchorPoint = node.anchor.pt;
-
-      jassert (lastAnchorPoint.x <= anchorPoint.x);
-
-      if (input <= anchorPoint.x) {
-        auto computeCubic = [](const PointType &p0, const PointType &p1, const PointType &p2, const PointType &p3,
-                               auto t) {
-          return p0 * std::pow(1 - t, 3.0) + p1 * 3 * std::pow(1 - t, 2.0) * t + p2 * 3 * (1 - t) * std::pow(t, 2.0) +
-                 p3 *
-                 std::pow(t, 3.0);
-        };
+      jassert (lastNode.anchor.pt.x <= node.anchor.pt.x);
 
-        auto computeQuadratic = [](const PointType &p0, const PointType &p1, const PointType &p2, auto t) {
-          return p0 * std::pow(1 - t, 2.0) + p1 * 2 * (1 - t) * t + p2 * std::pow(t, 2.0);
-        };
-
-        switch (lastNode.curveType) {
-          case CurveType::Cubic: {
-            const auto &ctrlPoint1 = lastNode.control1.pt;
-            const auto &ctrlPoint2 = lastNode.control2.pt;
-            float finalT = 0.0f;
-            float minDist = -1.0f;
-            for (int j = 0; j <= 100; j++) {
-              const float t = static_cast<float> (j) / 100.0f;
-              const float x = computeCubic(lastAnchorPoint, ctrlPoint1, ctrlPoint2, anchorPoint, t).x;
-              const float distance = std::abs(x - input);
-              if (distance < minDist || minDist < 0.0f) {
-                finalT = t;
-                minDist = distance;
-              }
-            }
-            return computeCubic(lastAnchorPoint, ctrlPoint1, ctrlPoint2, anchorPoint, finalT).y;
-          }
-          case CurveType::Quadratic: {
-            const auto &ctrlPoint = lastNode.control1.pt;
-            float finalT = 0.0f;
-            float minDist = -1.0f;
-            for (int j = 0; j <= 100; j++) {
-              const float t = static_cast<float> (j) / 100.0f;
-              const float x = computeQuadratic(lastAnchorPoint, ctrlPoint, anchorPoint, t).x;
-              const float distance = std::abs(x - input);
-              if (distance < minDist || minDist < 0.0f) {
-                finalT = t;
-                minDist = distance;
-              }
-            }
-            return computeQuadratic(lastAnchorPoint, ctrlPoint, anchorPoint, finalT).y;
-          }
-          default:
-          case CurveType::Linear:
-            const auto slope = (anchorPoint.y - lastAnchorPoint.y) / (anchorPoint.x - lastAnchorPoint.x);
-            return slope * (input - lastAnchorPoint.x) + lastAnchorPoint.y;
-        }
+      if (input <= node.anchor.pt.x) {
+        return CurveEvaluator<T>::solve(coefficients(lastNode, node), input);
       }
     }
     jassertfalse; // TODO
@@ -183,21 +204,22 @@ namespace ce {
   }
 
   template<typename T>
-  class CurveEditor : public juce::Component, juce::Value::Listener {
+  class CurveEditor : public juce::Component {
     using PointType = typename CurveEditorModel<T>::PointType;
     using Handle = typename CurveEditorModel<T>::Handle;
     using Node = typename CurveEditorModel<T>::Node;
     using CurveType = typename CurveEditorModel<T>::CurveType;
   public:
     explicit CurveEditor(CurveEditorModel<T> &m) :
-      model(m) {
-      lastInputValue.referTo(model.lastInputValue);
-      lastInputValue.addListener(this);
+      model(m),
+      lastInputReader(*m.lastInput) {
+      lastInputReader.onChange = [this](T value) {
+        lastInputValue = value;
+        repaint();
+      };
     }
 
-    ~CurveEditor() override {
-      lastInputValue.removeListener(this);
-    }
+    ~CurveEditor() override = default;
 
     void drawReadableSingleLineText(juce::Graphics &g, const typename CurveEditorModel<T>::PointType &baseline,
                                     const std::string &text,
@@ -217,8 +239,6 @@ namespace ce {
 
     void resized() override;
 
-    void valueChanged(juce::Value &value) override;
-
     void addPoint(const PointType &p);
 
     /**
@@ -235,13 +255,19 @@ namespace ce {
 
     PointType transformPointFromScreenSpace(const PointType &p) const;
 
+    void renderBackground(float scale);
+
   private:
     const float POINT_SIZE = 10.0f;
     const float DISTANCE_THRESHOLD = POINT_SIZE * 2.0f;
     juce::AffineTransform screenSpaceTransform;
     Handle *selectedHandle = nullptr;
     CurveEditorModel<T> &model;
-    juce::Value lastInputValue;
+    TelemetryReader<T> lastInputReader;
+    T lastInputValue{};
+    juce::Image cachedBackground;
+    std::uint32_t cachedVersion{};
+    float cachedScale{};
   };
 
   template<typename T>
@@ -268,8 +294,17 @@ namespace ce {
 
   template<typename T>
   void CurveEditor<T>::paint(juce::Graphics &g) {
-    g.setColour(juce::Colours::black);
-    g.fillRect(0, 0, getWidth(), getHeight());
+    // The curve and the grid only change with the model, they are drawn once into an image and blitted
+    // on every other repaint, e.g. the ones triggered by incoming MIDI moving the input indicator
+    const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    if (cachedBackground.isNull() ||
+        cachedVersion != model.getVersion() ||
+        cachedScale != scale ||
+        cachedBackground.getWidth() != juce::roundToInt(static_cast<float> (getWidth()) * scale) ||
+        cachedBackground.getHeight() != juce::roundToInt(static_cast<float> (getHeight()) * scale)) {
+      renderBackground(scale);
+    }
+    g.drawImage(cachedBackground, getLocalBounds().toFloat());
 
     // Record mouse coordinates in screen/model space
     const PointType screenSpaceMousePt = getMouseXYRelative().toFloat();
@@ -321,33 +356,11 @@ namespace ce {
       }
     };
 
-    // Draw the actual curve
-    juce::Path curve;
-    for (size_t i = 0; i < model.nodes.size(); i++) {
-      const auto transformedAnchorPoint = transformPointToScreenSpace(model.nodes[i]->anchor.pt);
-      if (i == 0)
-        curve.startNewSubPath(transformedAnchorPoint);
-      else {
-        CurveType curve_type = model.nodes[i - 1]->curveType;
-        if (curve_type == CurveType::Linear) {
-          curve.lineTo(transformedAnchorPoint);
-        } else if (curve_type == CurveType::Quadratic) {
-          const auto transformedControlPoint1 = transformPointToScreenSpace(model.nodes[i - 1]->control1.pt);
-          curve.quadraticTo(transformedControlPoint1.x, transformedControlPoint1.y, transformedAnchorPoint.x,
-                            transformedAnchorPoint.y);
-        } else if (curve_type == CurveType::Cubic) {
-          const auto transformedControlPoint1 = transformPointToScreenSpace(model.nodes[i - 1]->control1.pt);
-          const auto transformedControlPoint2 = transformPointToScreenSpace(model.nodes[i - 1]->control2.pt);
-          curve.cubicTo(transformedControlPoint1.x, transformedControlPoint1.y, transformedControlPoint2.x,
-                        transformedControlPoint2.y, transformedAnchorPoint.x, transformedAnchorPoint.y);
-        }
-      }
-      drawHandles(*model.nodes[i]);
+    // Handles follow hover and selection, they stay out of the cached image
+    for (const auto &node: model.nodes) {
+      drawHandles(*node);
     }
 
-    g.setColour(juce::Colours::whitesmoke);
-    g.strokePath(curve, juce::PathStrokeType(1.0f));
-
     // Draw reference line from the mouse pointer to the curve
     if (!selectedHandle && contains(getMouseXYRelative())) {
       const auto modelSpaceCurvePt = PointType(modelSpaceMousePt.x, model.compute(modelSpaceMousePt.x));
@@ -377,7 +390,7 @@ namespace ce {
     // Draw reference line for most recent input/output
     {
       g.setColour(juce::Colours::lightblue);
-      T inputValue = lastInputValue.getValue();
+      T inputValue = lastInputValue;
       T outputValue = model.compute(inputValue);
       const auto screenSpaceCurvePt = transformPointToScreenSpace(PointType(inputValue, outputValue));
       g.drawVerticalLine(static_cast<int> (screenSpaceCurvePt.x), screenSpaceCurvePt.y,
@@ -386,7 +399,47 @@ namespace ce {
       ostr << std::fixed << std::setprecision(0) << "[" << inputValue << ", " << outputValue << "]";
       drawReadableSingleLineText(g, screenSpaceCurvePt, ostr.str());
     }
+  }
 
+  template<typename T>
+  void CurveEditor<T>::renderBackground(float scale) {
+    cachedBackground = juce::Image(juce::Image::ARGB,
+                                   juce::jmax(1, juce::roundToInt(static_cast<float> (getWidth()) * scale)),
+                                   juce::jmax(1, juce::roundToInt(static_cast<float> (getHeight()) * scale)),
+                                   false);
+    cachedVersion = model.getVersion();
+    cachedScale = scale;
+
+    juce::Graphics g(cachedBackground);
+    g.addTransform(juce::AffineTransform::scale(scale));
+    g.setColour(juce::Colours::black);
+    g.fillRect(0, 0, getWidth(), getHeight());
+
+    // Draw the actual curve
+    juce::Path curve;
+    for (size_t i = 0; i < model.nodes.size(); i++) {
+      const auto transformedAnchorPoint = transformPointToScreenSpace(model.nodes[i]->anchor.pt);
+      if (i == 0)
+        curve.startNewSubPath(transformedAnchorPoint);
+      else {
+        CurveType curve_type = model.nodes[i - 1]->curveType;
+        if (curve_type == CurveType::Linear) {
+          curve.lineTo(transformedAnchorPoint);
+        } else if (curve_type == CurveType::Quadratic) {
+          const auto transformedControlPoint1 = transformPointToScreenSpace(model.nodes[i - 1]->control1.pt);
+          curve.quadraticTo(transformedControlPoint1.x, transformedControlPoint1.y, transformedAnchorPoint.x,
+                            transformedAnchorPoint.y);
+        } else if (curve_type == CurveType::Cubic) {
+          const auto transformedControlPoint1 = transformPointToScreenSpace(model.nodes[i - 1]->control1.pt);
+          const auto transformedControlPoint2 = transformPointToScreenSpace(model.nodes[i - 1]->control2.pt);
+          curve.cubicTo(transformedControlPoint1.x, transformedControlPoint1.y, transformedControlPoint2.x,
+                        transformedControlPoint2.y, transformedAnchorPoint.x, transformedAnchorPoint.y);
+        }
+      }
+    }
+
+    g.setColour(juce::Colours::whitesmoke);
+    g.strokePath(curve, juce::PathStrokeType(1.0f));
 
     // Draw grid
     auto numXTicks = 10; // TODO: Make these editable parameters
@@ -430,6 +483,7 @@ namespace ce {
         }
         if (toErase != -1) {
           model.nodes.erase(model.nodes.begin() + toErase);
+          model.bake();
         }
         selectedHandle = nullptr;
       }
@@ -503,6 +557,7 @@ namespace ce {
         }
       }
 
+      model.bake();
       repaint();
     }
   }
@@ -546,6 +601,7 @@ namespace ce {
         closestHandle->parent->setControlPt1(controlPoint1);
         closestHandle->parent->setControlPt2(controlPoint2);
       }
+      model.bake();
     }
   }
 
@@ -563,17 +619,13 @@ namespace ce {
                                                        ));
   }
 
-  template<typename T>
-  void CurveEditor<T>::valueChanged(juce::Value &) {
-    repaint();
-  }
-
   template<typename T>
   void CurveEditor<T>::addPoint(const PointType &p) {
     for (size_t i = 0; i < model.nodes.size(); i++) {
       const auto &point = *model.nodes[i];
       if (p.x <= point.anchor.pt.x) {
         model.nodes.emplace(model.nodes.begin() + static_cast<int>(i), std::make_shared<Node>(p));
+        model.bake();
         repaint();
         return;
       }
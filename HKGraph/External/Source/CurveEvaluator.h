@@ -0,0 +1,152 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include <span>
+
+namespace ce {
+  /**
+   * An immutable snapshot of a piecewise Bézier curve, evaluated exactly.
+   *
+   * Every segment is stored as a cubic in power basis (linear and quadratic segments are elevated), in
+   * flat arrays, one per coefficient. Evaluating inverts x(t) with a fixed number of bisection steps
+   * followed by Newton steps, so the same branch-free kernel runs for every input and the batch
+   * `compute` vectorises.
+   */
+  template<typename T>
+  class CurveEvaluator {
+  public:
+    using PointType = juce::Point<T>;
+
+    struct Coefficients {
+      T ax, bx, cx, dx;
+      T ay, by, cy, dy;
+    };
+
+    static Coefficients makeCubic(const PointType &p0, const PointType &p1, const PointType &p2,
+                                  const PointType &p3) {
+      const auto a = p3 - p0 + (p1 - p2) * static_cast<T> (3);
+      const auto b = (p0 - p1 * static_cast<T> (2) + p2) * static_cast<T> (3);
+      const auto c = (p1 - p0) * static_cast<T> (3);
+      return {a.x, b.x, c.x, p0.x, a.y, b.y, c.y, p0.y};
+    }
+
+    static Coefficients makeQuadratic(const PointType &p0, const PointType &p1, const PointType &p2) {
+      constexpr auto twoThirds = static_cast<T> (2) / static_cast<T> (3);
+      return makeCubic(p0, p0 + (p1 - p0) * twoThirds, p2 + (p1 - p2) * twoThirds, p2);
+    }
+
+    static Coefficients makeLinear(const PointType &p0, const PointType &p1) {
+      const auto d = p1 - p0;
+      return {0, 0, d.x, p0.x, 0, 0, d.y, p0.y};
+    }
+
+    /**
+     * y for the given x on a single segment, x is clamped to the segment's range
+     */
+    static T solve(const Coefficients &k, T x) {
+      return solve(k.ax, k.bx, k.cx, k.dx, k.ay, k.by, k.cy, k.dy, x);
+    }
+
+    void clear() {
+      ax.clear(), bx.clear(), cx.clear(), dx.clear();
+      ay.clear(), by.clear(), cy.clear(), dy.clear();
+      xEnd.clear();
+    }
+
+    void addSegment(const Coefficients &k) {
+      ax.push_back(k.ax), bx.push_back(k.bx), cx.push_back(k.cx), dx.push_back(k.dx);
+      ay.push_back(k.ay), by.push_back(k.by), cy.push_back(k.cy), dy.push_back(k.dy);
+      xEnd.push_back(k.ax + k.bx + k.cx + k.dx);
+    }
+
+    [[nodiscard]] size_t getNumSegments() const {
+      return xEnd.size();
+    }
+
+    [[nodiscard]] T compute(T x) const {
+      jassert (!xEnd.empty());
+      const auto s = segmentOf(x);
+      return solve(ax[s], bx[s], cx[s], dx[s], ay[s], by[s], cy[s], dy[s], x);
+    }
+
+    /**
+     * Evaluate many inputs at once, `out` must be at least as large as `in`
+     */
+    void compute(std::span<const T> in, std::span<T> out) const {
+      jassert (!xEnd.empty() && out.size() >= in.size());
+      constexpr size_t Chunk = 64;
+      std::array<T, Chunk> kax, kbx, kcx, kdx, kay, kby, kcy, kdy;
+      for (size_t base = 0; base < in.size(); base += Chunk) {
+        const auto n = std::min(Chunk, in.size() - base);
+        // gather the coefficients of each input's segment, then run the kernel over plain arrays
+        for (size_t j = 0; j < n; j++) {
+          const auto s = segmentOf(in[base + j]);
+          kax[j] = ax[s], kbx[j] = bx[s], kcx[j] = cx[s], kdx[j] = dx[s];
+          kay[j] = ay[s], kby[j] = by[s], kcy[j] = cy[s], kdy[j] = dy[s];
+        }
+        for (size_t j = 0; j < n; j++) {
+          out[base + j] = solve(kax[j], kbx[j], kcx[j], kdx[j], kay[j], kby[j], kcy[j], kdy[j], in[base + j]);
+        }
+      }
+    }
+
+  private:
+    static constexpr int BisectionSteps = 16;
+    static constexpr int NewtonSteps = 3;
+
+    static T solve(T ax, T bx, T cx, T dx, T ay, T by, T cy, T dy, T x) {
+      // the editor keeps control points between their anchors, so x(t) is increasing on [0, 1]
+      T lo = 0, hi = 1;
+      for (int i = 0; i < BisectionSteps; i++) {
+        const T mid = (lo + hi) * static_cast<T> (0.5);
+        const T xm = ((ax * mid + bx) * mid + cx) * mid + dx;
+        const bool below = xm < x;
+        lo = below ? mid : lo;
+        hi = below ? hi : mid;
+      }
+      T t = (lo + hi) * static_cast<T> (0.5);
+      for (int i = 0; i < NewtonSteps; i++) {
+        const T f = ((ax * t + bx) * t + cx) * t + dx - x;
+        const T d = (static_cast<T> (3) * ax * t + static_cast<T> (2) * bx) * t + cx;
+        const T step = d != 0 ? f / d : 0;
+        t = std::clamp(t - step, lo, hi);
+      }
+      return ((ay * t + by) * t + cy) * t + dy;
+    }
+
+    [[nodiscard]] size_t segmentOf(T x) const {
+      const auto itr = std::lower_bound(xEnd.begin(), xEnd.end(), x);
+      return std::min(static_cast<size_t> (itr - xEnd.begin()), xEnd.size() - 1);
+    }
+
+    std::vector<T> ax, bx, cx, dx;
+    std::vector<T> ay, by, cy, dy;
+    std::vector<T> xEnd;
+  };
+
+  /**
+   * A curve baked for `Size` inputs spread evenly over [minX, maxX]. Entries are atomic so the audio
+   * thread reads them with a single load while the editor rebakes.
+   */
+  template<typename T, int Size>
+  struct CurveTable {
+    std::array<std::atomic<T>, Size> values{};
+    std::atomic<std::uint32_t> version{0};
+
+    void bake(const CurveEvaluator<T> &evaluator, T minX, T maxX) {
+      std::vector<T> in(Size), out(Size);
+      for (int i = 0; i < Size; i++) {
+        in[static_cast<size_t> (i)] = minX + (maxX - minX) * static_cast<T> (i) / static_cast<T> (Size - 1);
+      }
+      evaluator.compute(in, out);
+      for (size_t i = 0; i < out.size(); i++) {
+        values[i].store(out[i], std::memory_order_relaxed);
+      }
+      version.fetch_add(1, std::memory_order_release);
+    }
+
+    [[nodiscard]] T lookup(int input) const {
+      return values[static_cast<size_t> (juce::jlimit(0, Size - 1, input))].load(std::memory_order_relaxed);
+    }
+  };
+}
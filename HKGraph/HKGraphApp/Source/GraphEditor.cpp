@@ -1,11 +1,11 @@
 #include "GraphEditor.h"
 
 juce::Component* SumProcessor::createEditor(const GraphViewTheme &theme) {
-  return new LabelPanel(this, theme, this);
+  return new LabelPanel(this, theme, m_value);
 }
 
 juce::Component* MonitorProcessor::createEditor(const GraphViewTheme &theme) {
-  return new LabelPanel(this, theme, this);
+  return new LabelPanel(this, theme, m_value);
 }
 
 juce::Component* TransposeProcessor::createEditor(const GraphViewTheme &theme) {
@@ -7,6 +7,7 @@
 #include "CurveEditor.h"
 #include "ConstrainedComponent.h"
 #include "GraphLookAndFeel.h"
+#include "TelemetrySlot.h"
 
 struct PassthroughProcessor : public NodeProcessor {
 
@@ -184,7 +185,8 @@ struct CurveProcessor : public NodeProcessor {
   on_data(Graph *graph, const std::optional<const Graph::Node::Pin> &pin, Data &data) override {
     juce::ignoreUnused(graph, pin);
     auto input = std::any_cast<int>(data);
-    Data output = std::make_any<int>(static_cast<int>(model.compute(static_cast<float>(input))));
+    model.lastInput->write(static_cast<float>(input));
+    Data output = std::make_any<int>(static_cast<int>(model.lookup(input)));
     for (auto &[_, p]: m_outs) {
       p.on_data(graph, output);
     }
@@ -246,37 +248,12 @@ private:
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CurvePanel)
 };
 
-template<typename ValueType>
-struct ValueProvider {
-
-  struct Listener {
-    virtual void on_value(const ValueType &value) = 0;
-  };
-
-  ValueProvider() = default;
-
-  void add_listener(Listener *listener) {
-    m_listeners.add(listener);
-  }
-
-  void remove_listener(Listener *listener) {
-    m_listeners.remove(listener);
-  }
-
-  void notify(const ValueType &value) {
-    m_listeners.call([&](Listener &l) { l.on_value(value); });
-  }
-
-private:
-  juce::ListenerList<Listener> m_listeners;
-  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ValueProvider)
-};
-
-struct SumProcessor : public NodeProcessor, public ValueProvider<int> {
+struct SumProcessor : public NodeProcessor {
   std::unordered_map<uuid, int> values;
+  TelemetrySlot<int> m_value;
 
   SumProcessor(Graph *graph, const std::string &name, uint32_t n_ins, uint32_t n_outs)
-    : NodeProcessor(graph, name, n_ins, n_outs), ValueProvider<int>() {}
+    : NodeProcessor(graph, name, n_ins, n_outs) {}
 
   ~SumProcessor() override = default;
 
@@ -288,7 +265,7 @@ struct SumProcessor : public NodeProcessor, public ValueProvider<int> {
     int sum = std::accumulate(std::begin(values), std::end(values), 0, [&](auto acc, auto &next) {
       return acc + next.second;
     });
-    notify(sum);
+    m_value.write(sum);
     Data output = std::make_any<int>(sum);
     for (auto &[_, p]: m_outs) {
       p.on_data(graph, output);
@@ -311,17 +288,18 @@ struct SumProcessor : public NodeProcessor, public ValueProvider<int> {
 
 };
 
-struct MonitorProcessor : public NodeProcessor, public ValueProvider<int> {
+struct MonitorProcessor : public NodeProcessor {
+  TelemetrySlot<int> m_value;
 
   MonitorProcessor(Graph *graph, const std::string &name, uint32_t n_ins, uint32_t n_outs)
-    : NodeProcessor(graph, name, n_ins, n_outs), ValueProvider<int>() {}
+    : NodeProcessor(graph, name, n_ins, n_outs) {}
 
   ~MonitorProcessor() override = default;
 
   void on_data(Graph *graph, const std::optional<const Node::Pin> &pin, Data &data) override {
     juce::ignoreUnused(pin);
     auto input = std::any_cast<int>(data);
-    notify(input);
+    m_value.write(input);
     for (auto &[_, p]: m_outs) {
       p.on_data(graph, data);
     }
@@ -343,24 +321,24 @@ struct MonitorProcessor : public NodeProcessor, public ValueProvider<int> {
 
 };
 
-struct LabelPanel : public juce::Component, public ValueProvider<int>::Listener {
+struct LabelPanel : public juce::Component {
   NodeProcessor *m_processor;
   GraphViewTheme m_theme;
-  ValueProvider<int> *m_value_provider;
+  TelemetryReader<int> m_reader;
   juce::Label m_label;
 
-  LabelPanel(NodeProcessor *p, const GraphViewTheme &viewTheme, ValueProvider<int> *valueProvider)
+  LabelPanel(NodeProcessor *p, const GraphViewTheme &viewTheme, const TelemetrySlot<int> &slot)
     : m_processor(p),
       m_theme(viewTheme),
-      m_value_provider(valueProvider) {
-    m_label.setText("0", juce::NotificationType::dontSendNotification);
+      m_reader(slot) {
+    m_label.setText(juce::String(slot.read()), juce::NotificationType::dontSendNotification);
     addAndMakeVisible(m_label);
-    m_value_provider->add_listener(this);
+    m_reader.onChange = [this](int value) {
+      m_label.setText(juce::String(value), juce::NotificationType::dontSendNotification);
+    };
   }
 
-  ~LabelPanel() override {
-    m_value_provider->remove_listener(this);
-  }
+  ~LabelPanel() override = default;
 
   void paint(juce::Graphics &g) override {
     g.fillAll(juce::Colour(m_theme.cNodeBackground));
@@ -374,10 +352,6 @@ struct LabelPanel : public juce::Component, public ValueProvider<int>::Listener
     m_label.centreWithSize(w, h);
   }
 
-  void on_value(const int &value) override {
-    m_label.setText(juce::String(value), juce::NotificationType::dontSendNotification);
-  }
-
 private:
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LabelPanel)
 };
@@ -1,5 +1,14 @@
 #include "Graph.h"
 
+namespace {
+  // accumulates the time the node running on this thread spends dispatching to its out pins
+  thread_local std::int64_t *t_downstream_ns = nullptr;
+
+  std::int64_t elapsed_ns(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - since).count();
+  }
+}
+
 Graph::Graph() {
   std::random_device rd;
   auto seed_data = std::array<int, std::mt19937::state_size>{};
@@ -37,6 +46,7 @@ void Graph::add_node(Node *node) {
     m_pins[p.first] = p.second;
   }
   m_nodes[id] = node;
+  notify_listeners(Graph::Event::NodeAdded);
 }
 
 void Graph::remove_node(const uuid &node_id) {
@@ -97,6 +107,7 @@ std::optional<Graph::Edge> Graph::connect(const uuid &source_pin_id, const uuid
       .m_target_pin_id = target_pin_itr->first,
     };
     m_edges[e.m_id] = e;
+    notify_listeners(Graph::Event::EdgeAdded);
     return e;
   }
   return std::nullopt;
@@ -140,6 +151,9 @@ void Graph::notify_listeners(const Graph::Event &event) {
 }
 
 void Graph::Node::Pin::async_dispatch(Graph *graph, Data &data) {
+  // only set while a node runs on this thread with telemetry on
+  auto *downstream = m_kind == PinKind::Out ? t_downstream_ns : nullptr;
+  auto start = downstream != nullptr ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
   if (graph->async) {
     auto f = std::async(
       std::launch::async,
@@ -148,6 +162,9 @@ void Graph::Node::Pin::async_dispatch(Graph *graph, Data &data) {
   } else {
     on_data(graph, data);
   }
+  if (downstream != nullptr) {
+    *downstream += elapsed_ns(start);
+  }
 }
 
 void Graph::Node::Pin::on_data(Graph *graph, Data &data) {
@@ -172,14 +189,29 @@ void Graph::Node::async_dispatch(Graph *graph, const std::optional<const Node::P
     if (graph->async) {
       auto f = std::async(
         std::launch::async,
-        [&](auto g, auto p, auto d) { this->on_data(g, p, d); }, graph, pin, data);
+        [&](auto g, auto p, auto d) { this->timed_on_data(g, p, d); }, graph, pin, data);
       f.wait();
     } else {
-      this->on_data(graph, pin, data);
+      this->timed_on_data(graph, pin, data);
     }
   }
 }
 
+void Graph::Node::timed_on_data(Graph *graph, const std::optional<const Node::Pin> &pin, Data &data) {
+  if (!graph->telemetry) {
+    on_data(graph, pin, data);
+    return;
+  }
+  std::int64_t downstream = 0;
+  auto *parent = t_downstream_ns;
+  t_downstream_ns = &downstream;
+  auto start = std::chrono::steady_clock::now();
+  on_data(graph, pin, data);
+  auto total = elapsed_ns(start);
+  t_downstream_ns = parent;
+  m_time.record(static_cast<std::uint64_t>(std::max<std::int64_t>(0, total - downstream)));
+}
+
 void Graph::Node::on_data(Graph *graph, const std::optional<const Node::Pin> &pin, Data &data) {
 }
 
@@ -195,6 +227,9 @@ void Graph::Edge::async_dispatch(Graph *graph, Data &data) const {
 }
 
 void Graph::Edge::on_data(Graph *graph, Data &data) const {
+  if (graph->m_data_listener != nullptr) {
+    graph->m_data_listener->on_edge_data(*this, data);
+  }
   auto p_itr = graph->m_pins.find(m_target_pin_id);
   if (p_itr != std::end(graph->m_pins)) {
     p_itr->second.async_dispatch(graph, data);
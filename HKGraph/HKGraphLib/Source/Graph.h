@@ -5,6 +5,7 @@
 #include <any>
 #include <future>
 #include "uuid.h"
+#include "Histogram.h"
 
 using uuid = uuids::uuid;
 using Data = std::any;
@@ -23,6 +24,13 @@ struct Graph {
     virtual void on_graph_event(const Event &event) = 0;
   };
 
+  struct Edge;
+
+  // observes every piece of data as it travels along an edge, called on the dispatching thread
+  struct DataListener {
+    virtual void on_edge_data(const Edge &edge, const Data &data) = 0;
+  };
+
   struct Node {
     enum class PinKind {
       In, Out
@@ -63,6 +71,8 @@ struct Graph {
 
     virtual void on_data(Graph *graph, const std::optional<const Node::Pin> &pin, Data &data);
 
+    void timed_on_data(Graph *graph, const std::optional<const Node::Pin> &pin, Data &data);
+
     void debug() const {
       std::cout
         << "Node " << m_name << " "
@@ -79,6 +89,8 @@ struct Graph {
     std::unordered_map<uuid, Pin> m_ins;
     std::unordered_map<uuid, Pin> m_outs;
     bool m_sticky{false};
+    // time spent in on_data excluding what the node dispatches downstream, in nanoseconds
+    Histogram m_time;
   protected:
     bool m_muted{false};
   };
@@ -126,11 +138,13 @@ struct Graph {
   void notify_listeners(const Graph::Event &event);
 
   bool async{true};
+  bool telemetry{true};
   std::unordered_map<uuid, Node *> m_nodes;
   std::unordered_map<uuid, Node::Pin> m_pins;
   std::unordered_map<uuid, Edge> m_edges;
   std::mutex m_mutex;
   std::vector<Listener *> m_listeners;
+  DataListener *m_data_listener{nullptr};
 private:
   std::mt19937 *m_mt19937;
   uuids::uuid_random_generator *m_uuid_generator;
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+// Lock-free log-linear histogram, in the spirit of HdrHistogram.
+//
+// Every power of two is split into 2^SubBucketBits linear buckets, so the relative error of a
+// reported value is bounded by 1 / 2^SubBucketBits whatever its magnitude. Values are plain
+// integers (the graph records nanoseconds), anything at or above 2^MaxBits lands in the last bucket.
+//
+// `record` is wait-free and safe to call from the audio thread, readers on other threads may
+// observe a sample counted in `count` before it shows up in its bucket, which only skews a
+// percentile by one sample.
+template<std::uint32_t SubBucketBits = 4, std::uint32_t MaxBits = 36>
+struct LogLinearHistogram {
+  static constexpr std::uint64_t SubBuckets = 1ull << SubBucketBits;
+  static constexpr std::size_t BucketCount = (MaxBits - SubBucketBits + 1) * SubBuckets;
+
+  void record(std::uint64_t value) {
+    m_buckets[index_of(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    auto max = m_max.load(std::memory_order_relaxed);
+    while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+  }
+
+  void reset() {
+    for (auto &b: m_buckets) {
+      b.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] std::uint64_t count() const {
+    return m_count.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] std::uint64_t max() const {
+    return m_max.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] double mean() const {
+    auto n = count();
+    return n == 0 ? 0.0 : static_cast<double>(m_sum.load(std::memory_order_relaxed)) / static_cast<double>(n);
+  }
+
+  // p in [0, 1], returns the upper bound of the bucket holding the p-th sample
+  [[nodiscard]] std::uint64_t percentile(double p) const {
+    auto n = count();
+    if (n == 0) return 0;
+    auto rank = static_cast<std::uint64_t>(p * static_cast<double>(n));
+    if (rank >= n) rank = n - 1;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < BucketCount; ++i) {
+      seen += m_buckets[i].load(std::memory_order_relaxed);
+      if (seen > rank) {
+        auto upper = upper_bound_of(i);
+        auto max = m_max.load(std::memory_order_relaxed);
+        return upper < max ? upper : max;
+      }
+    }
+    return max();
+  }
+
+  static constexpr std::size_t index_of(std::uint64_t value) {
+    if (value < SubBuckets) return static_cast<std::size_t>(value);
+    auto msb = static_cast<std::uint32_t>(63 - std::countl_zero(value));
+    if (msb >= MaxBits) return BucketCount - 1;
+    auto shift = msb - SubBucketBits;
+    return static_cast<std::size_t>((shift + 1) * SubBuckets + ((value >> shift) & (SubBuckets - 1)));
+  }
+
+  static constexpr std::uint64_t upper_bound_of(std::size_t index) {
+    if (index < SubBuckets) return index;
+    auto shift = static_cast<std::uint32_t>(index / SubBuckets - 1);
+    auto sub = static_cast<std::uint64_t>(index % SubBuckets);
+    return ((SubBuckets + sub + 1) << shift) - 1;
+  }
+
+private:
+  std::array<std::atomic<std::uint64_t>, BucketCount> m_buckets{};
+  std::atomic<std::uint64_t> m_count{0};
+  std::atomic<std::uint64_t> m_sum{0};
+  std::atomic<std::uint64_t> m_max{0};
+};
+
+using Histogram = LogLinearHistogram<>;
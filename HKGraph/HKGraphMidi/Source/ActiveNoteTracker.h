@@ -0,0 +1,105 @@
+#pragma once
+
+#include <bit>
+#include "JuceHeader.h"
+#include "EventBuffer.h"
+#include "RawMidi.h"
+
+// The set of notes currently sounding, one bit per (channel, note) pair: 16 channels x 128 notes
+// in 32 words. Used to release exactly the notes a path has started instead of sending all-notes-off
+// on every channel. Not thread safe, it is meant to be owned by whoever runs the audio thread.
+struct ActiveNoteTracker {
+  static constexpr int Channels = 16;
+  static constexpr int Notes = 128;
+
+  // channel is 1-based like juce::MidiMessage, out of range notes are ignored
+  void noteOn(int channel, int note) {
+    if (inRange(channel, note)) m_bits[word(channel, note)] |= bit(note);
+  }
+
+  void noteOff(int channel, int note) {
+    if (inRange(channel, note)) m_bits[word(channel, note)] &= ~bit(note);
+  }
+
+  [[nodiscard]] bool isOn(int channel, int note) const {
+    return inRange(channel, note) && (m_bits[word(channel, note)] & bit(note)) != 0;
+  }
+
+  void clearChannel(int channel) {
+    if (channel < 1 || channel > Channels) return;
+    m_bits[word(channel, 0)] = 0;
+    m_bits[word(channel, 0) + 1] = 0;
+  }
+
+  void clear() {
+    m_bits.fill(0);
+  }
+
+  [[nodiscard]] bool any() const {
+    for (auto w: m_bits) {
+      if (w != 0) return true;
+    }
+    return false;
+  }
+
+  void merge(const ActiveNoteTracker &other) {
+    for (size_t i = 0; i < m_bits.size(); ++i) {
+      m_bits[i] |= other.m_bits[i];
+    }
+  }
+
+  void process(const juce::MidiMessage &message) {
+    if (message.isNoteOn()) {
+      noteOn(message.getChannel(), message.getNoteNumber());
+    } else if (message.isNoteOff()) {
+      noteOff(message.getChannel(), message.getNoteNumber());
+    } else if (message.isAllNotesOff() || message.isAllSoundOff()) {
+      clearChannel(message.getChannel());
+    }
+  }
+
+  // walks the events in place, nothing is decoded or allocated
+  void process(const EventBuffer &buffer) {
+    for (auto m: buffer) {
+      if (!RawMidi::isChannelMessage(m.data, m.numBytes)) continue;
+      auto channel = (m.data[0] & 0x0F) + 1;
+      if (RawMidi::isNoteOn(m.data, m.numBytes)) {
+        noteOn(channel, m.data[1]);
+      } else if (RawMidi::isNoteOff(m.data, m.numBytes)) {
+        noteOff(channel, m.data[1]);
+      } else if (m.numBytes == 3 && (m.data[0] & 0xF0) == 0xB0 && (m.data[1] == 120 || m.data[1] == 123)) {
+        clearChannel(channel); // all sound off, all notes off
+      }
+    }
+  }
+
+  // appends a note-off for every sounding note and forgets them
+  void releaseAll(EventBuffer &output, int samplePosition) {
+    for (size_t i = 0; i < m_bits.size(); ++i) {
+      auto w = m_bits[i];
+      while (w != 0) {
+        auto b = std::countr_zero(w);
+        auto channel = static_cast<int>(i / 2) + 1;
+        auto note = static_cast<int>((i % 2) * 64) + b;
+        output.addEvent(juce::MidiMessage::noteOff(channel, note), samplePosition);
+        w &= w - 1;
+      }
+      m_bits[i] = 0;
+    }
+  }
+
+private:
+  static bool inRange(int channel, int note) {
+    return channel >= 1 && channel <= Channels && note >= 0 && note < Notes;
+  }
+
+  static size_t word(int channel, int note) {
+    return static_cast<size_t>((channel - 1) * 2 + note / 64);
+  }
+
+  static std::uint64_t bit(int note) {
+    return std::uint64_t{1} << (note % 64);
+  }
+
+  std::array<std::uint64_t, 32> m_bits{};
+};
@@ -0,0 +1,248 @@
+#include "BlockCapture.h"
+
+BlockCapture::BlockCapture(int capacityInBytes)
+  : juce::Thread("block-capture"),
+    fifo(capacityInBytes),
+    ring(static_cast<size_t>(capacityInBytes)) {
+}
+
+BlockCapture::~BlockCapture() {
+  stop();
+}
+
+bool BlockCapture::start(const juce::File &file, std::uint64_t blockIndex, const juce::MemoryBlock &state) {
+  stop();
+
+  file.deleteFile();
+  out = std::make_unique<juce::FileOutputStream>(file);
+  if (!out->openedOk()) {
+    out.reset();
+    return false;
+  }
+  out->writeInt(static_cast<int>(magic));
+  out->writeInt(static_cast<int>(version));
+
+  fifo.reset();
+  droppedBlocks = 0;
+  {
+    std::lock_guard<std::mutex> lock(topologyMutex);
+    topologyChunks.clear();
+  }
+  heldTopology.clear();
+  writeTopology(blockIndex, fullState, state);
+
+  active.store(true, std::memory_order_release);
+  startThread();
+  return true;
+}
+
+void BlockCapture::stop() {
+  active.store(false, std::memory_order_release);
+  // the writer drains whatever is left before exiting
+  stopThread(2000);
+  if (out != nullptr) {
+    out->flush();
+    out.reset();
+  }
+}
+
+void BlockCapture::writeBlock(std::uint64_t blockIndex, double sampleRate, int numSamples,
+                              const juce::MidiBuffer &midi) {
+  if (!isActive()) return;
+
+  auto numEvents = 0;
+  auto size = static_cast<int>(sizeof(std::uint8_t) + sizeof(std::uint64_t) + sizeof(double) + 2 * sizeof(std::int32_t));
+  for (auto m: midi) {
+    size += static_cast<int>(sizeof(std::int32_t) + sizeof(std::uint16_t)) + m.numBytes;
+    ++numEvents;
+  }
+
+  if (fifo.getFreeSpace() < size) {
+    ++droppedBlocks;
+    return;
+  }
+
+  // a chunk is committed to the ring as a whole, the writer never sees half a block. Fields are
+  // stored little endian, as CaptureReader reads them
+  const auto scope = fifo.write(size);
+  auto written = 0;
+  auto type = static_cast<std::uint8_t>(ChunkType::Block);
+  auto index = juce::ByteOrder::swapIfBigEndian(static_cast<juce::uint64>(blockIndex));
+  juce::uint64 rate;
+  std::memcpy(&rate, &sampleRate, sizeof(rate));
+  rate = juce::ByteOrder::swapIfBigEndian(rate);
+  auto samples = juce::ByteOrder::swapIfBigEndian(static_cast<juce::uint32>(numSamples));
+  auto events = juce::ByteOrder::swapIfBigEndian(static_cast<juce::uint32>(numEvents));
+  copyToFifo(scope, written, &type, sizeof(type));
+  copyToFifo(scope, written, &index, sizeof(index));
+  copyToFifo(scope, written, &rate, sizeof(rate));
+  copyToFifo(scope, written, &samples, sizeof(samples));
+  copyToFifo(scope, written, &events, sizeof(events));
+  for (auto m: midi) {
+    auto position = juce::ByteOrder::swapIfBigEndian(static_cast<juce::uint32>(m.samplePosition));
+    auto numBytes = juce::ByteOrder::swapIfBigEndian(static_cast<juce::uint16>(m.numBytes));
+    copyToFifo(scope, written, &position, sizeof(position));
+    copyToFifo(scope, written, &numBytes, sizeof(numBytes));
+    copyToFifo(scope, written, m.data, m.numBytes);
+  }
+}
+
+void BlockCapture::writeTopology(std::uint64_t blockIndex, int event, const juce::MemoryBlock &state) {
+  juce::MemoryBlock chunk;
+  {
+    juce::MemoryOutputStream stream{chunk, false};
+    stream.writeByte(static_cast<char>(ChunkType::Topology));
+    stream.writeInt64(static_cast<juce::int64>(blockIndex));
+    stream.writeInt(event);
+    stream.writeInt(static_cast<int>(state.getSize()));
+    stream.write(state.getData(), state.getSize());
+  }
+  std::lock_guard<std::mutex> lock(topologyMutex);
+  topologyChunks.push_back({blockIndex, std::move(chunk)});
+}
+
+void BlockCapture::copyToFifo(const juce::AbstractFifo::ScopedWrite &scope, int &written, const void *source,
+                              int size) {
+  auto bytes = static_cast<const std::uint8_t *>(source);
+  while (size > 0) {
+    std::uint8_t *destination;
+    int available;
+    if (written < scope.blockSize1) {
+      destination = ring.get() + scope.startIndex1 + written;
+      available = scope.blockSize1 - written;
+    } else {
+      destination = ring.get() + scope.startIndex2 + (written - scope.blockSize1);
+      available = scope.blockSize2 - (written - scope.blockSize1);
+    }
+    auto n = std::min(size, available);
+    std::memcpy(destination, bytes, static_cast<size_t>(n));
+    bytes += n;
+    size -= n;
+    written += n;
+  }
+}
+
+void BlockCapture::copyFromFifo(const juce::AbstractFifo::ScopedRead &scope, int offset, void *destination,
+                                int size) const {
+  auto bytes = static_cast<std::uint8_t *>(destination);
+  while (size > 0) {
+    const std::uint8_t *source;
+    int available;
+    if (offset < scope.blockSize1) {
+      source = ring.get() + scope.startIndex1 + offset;
+      available = scope.blockSize1 - offset;
+    } else {
+      source = ring.get() + scope.startIndex2 + (offset - scope.blockSize1);
+      available = scope.blockSize2 - (offset - scope.blockSize1);
+    }
+    auto n = std::min(size, available);
+    std::memcpy(bytes, source, static_cast<size_t>(n));
+    bytes += n;
+    size -= n;
+    offset += n;
+  }
+}
+
+void BlockCapture::writeFromFifo(const juce::AbstractFifo::ScopedRead &scope, int offset, int size) {
+  if (offset < scope.blockSize1) {
+    auto n = std::min(size, scope.blockSize1 - offset);
+    out->write(ring.get() + scope.startIndex1 + offset, static_cast<size_t>(n));
+    offset += n;
+    size -= n;
+  }
+  if (size > 0) {
+    out->write(ring.get() + scope.startIndex2 + (offset - scope.blockSize1), static_cast<size_t>(size));
+  }
+}
+
+void BlockCapture::run() {
+  while (!threadShouldExit()) {
+    drain(false);
+    wait(20);
+  }
+  drain(true);
+}
+
+void BlockCapture::drain(bool last) {
+  {
+    std::lock_guard<std::mutex> lock(topologyMutex);
+    for (auto &chunk: topologyChunks) {
+      heldTopology.push_back(std::move(chunk));
+    }
+    topologyChunks.clear();
+  }
+  // a change stamped with block N applies before block N: it is written right before the first block
+  // that is at least N, and held back while that block is not captured yet
+  size_t written = 0;
+  auto writeTopologyUpTo = [this, &written](std::uint64_t blockIndex) {
+    while (written < heldTopology.size() && heldTopology[written].blockIndex <= blockIndex) {
+      auto const &bytes = heldTopology[written].bytes;
+      out->write(bytes.getData(), bytes.getSize());
+      ++written;
+    }
+  };
+
+  auto ready = fifo.getNumReady();
+  if (ready > 0) {
+    const auto scope = fifo.read(ready);
+    // the ring only holds whole block chunks, walk them one by one
+    auto offset = 0;
+    while (offset < ready) {
+      juce::uint64 blockIndex;
+      juce::uint32 numEvents;
+      copyFromFifo(scope, offset + static_cast<int>(sizeof(std::uint8_t)), &blockIndex, sizeof(blockIndex));
+      auto size = static_cast<int>(sizeof(std::uint8_t) + sizeof(std::uint64_t) + sizeof(double) + sizeof(std::int32_t));
+      copyFromFifo(scope, offset + size, &numEvents, sizeof(numEvents));
+      size += static_cast<int>(sizeof(std::int32_t));
+      numEvents = juce::ByteOrder::swapIfBigEndian(numEvents);
+      for (juce::uint32 i = 0; i < numEvents; ++i) {
+        juce::uint16 numBytes;
+        copyFromFifo(scope, offset + size + static_cast<int>(sizeof(std::int32_t)), &numBytes, sizeof(numBytes));
+        size += static_cast<int>(sizeof(std::int32_t) + sizeof(std::uint16_t)) + juce::ByteOrder::swapIfBigEndian(numBytes);
+      }
+      writeTopologyUpTo(juce::ByteOrder::swapIfBigEndian(blockIndex));
+      writeFromFifo(scope, offset, size);
+      offset += size;
+    }
+  }
+
+  if (last) {
+    writeTopologyUpTo(std::numeric_limits<std::uint64_t>::max());
+  }
+  heldTopology.erase(std::begin(heldTopology), std::begin(heldTopology) + static_cast<std::ptrdiff_t>(written));
+}
+
+CaptureReader::CaptureReader(const juce::File &file) : in(file) {
+  if (in.openedOk()) {
+    auto m = static_cast<std::uint32_t>(in.readInt());
+    auto v = static_cast<std::uint32_t>(in.readInt());
+    valid = m == BlockCapture::magic && v == BlockCapture::version;
+  }
+}
+
+bool CaptureReader::next(CaptureChunk &chunk) {
+  if (!valid || in.isExhausted()) return false;
+
+  chunk.type = static_cast<BlockCapture::ChunkType>(in.readByte());
+  chunk.blockIndex = static_cast<std::uint64_t>(in.readInt64());
+  if (chunk.type == BlockCapture::ChunkType::Block) {
+    chunk.sampleRate = in.readDouble();
+    chunk.numSamples = in.readInt();
+    auto numEvents = in.readInt();
+    chunk.midi.clear();
+    for (auto i = 0; i < numEvents; ++i) {
+      auto position = in.readInt();
+      auto numBytes = static_cast<std::uint16_t>(in.readShort());
+      eventBytes.resize(numBytes);
+      if (in.read(eventBytes.data(), numBytes) != numBytes) return false;
+      chunk.midi.addEvent(eventBytes.data(), numBytes, position);
+    }
+    return true;
+  } else if (chunk.type == BlockCapture::ChunkType::Topology) {
+    chunk.event = in.readInt();
+    auto size = in.readInt();
+    chunk.state.setSize(static_cast<size_t>(size));
+    return in.read(chunk.state.getData(), size) == size;
+  }
+  return false;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+// Records the exact stream of blocks a host feeds to `processBlock`, together with every topology
+// change, so a session can be replayed headlessly later on.
+//
+// File layout (little endian):
+//   header:   u32 magic, u32 version
+//   chunk:    u8 type, u64 block index, then
+//     Block:    f64 sample rate, i32 number of samples, i32 number of events,
+//               events as (i32 sample position, u16 size, bytes)
+//     Topology: i32 graph event (-1 for a full state), u32 state size, state bytes
+//
+// A topology chunk carries a snapshot of the plugin state taken right after the change, and applies
+// before the block with the same index. Chunks are written in the order they apply: a topology
+// chunk comes right before the first block with an index at least its own.
+//
+// Blocks are written by the audio thread into a preallocated ring without locking or allocating,
+// and a writer thread drains the ring to disk. When the ring is full the block is dropped and counted.
+class BlockCapture : private juce::Thread {
+public:
+  static constexpr std::uint32_t magic = 0x43474b48; // "HKGC"
+  static constexpr std::uint32_t version = 1;
+  static constexpr int fullState = -1;
+
+  enum class ChunkType : std::uint8_t {
+    Block = 1,
+    Topology = 2,
+  };
+
+  explicit BlockCapture(int capacityInBytes = 1 << 22);
+
+  ~BlockCapture() override;
+
+  bool start(const juce::File &file, std::uint64_t blockIndex, const juce::MemoryBlock &state);
+
+  void stop();
+
+  [[nodiscard]] bool isActive() const {
+    return active.load(std::memory_order_acquire);
+  }
+
+  [[nodiscard]] int getNumDroppedBlocks() const {
+    return droppedBlocks.load();
+  }
+
+  // audio thread only
+  void writeBlock(std::uint64_t blockIndex, double sampleRate, int numSamples, const juce::MidiBuffer &midi);
+
+  // any thread but the audio thread
+  void writeTopology(std::uint64_t blockIndex, int event, const juce::MemoryBlock &state);
+
+private:
+  void run() override;
+
+  struct TopologyChunk {
+    std::uint64_t blockIndex;
+    juce::MemoryBlock bytes;
+  };
+
+  // the last drain writes out every topology chunk still held back
+  void drain(bool last);
+
+  void copyToFifo(const juce::AbstractFifo::ScopedWrite &scope, int &written, const void *source, int size);
+
+  void copyFromFifo(const juce::AbstractFifo::ScopedRead &scope, int offset, void *destination, int size) const;
+
+  void writeFromFifo(const juce::AbstractFifo::ScopedRead &scope, int offset, int size);
+
+  juce::AbstractFifo fifo;
+  juce::HeapBlock<std::uint8_t> ring;
+  std::unique_ptr<juce::FileOutputStream> out;
+  std::mutex topologyMutex;
+  std::vector<TopologyChunk> topologyChunks;
+  // writer thread only, chunks waiting for their block to be drained, in the order they were queued
+  std::vector<TopologyChunk> heldTopology;
+  std::atomic<bool> active{false};
+  std::atomic<int> droppedBlocks{0};
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BlockCapture)
+};
+
+struct CaptureChunk {
+  BlockCapture::ChunkType type{BlockCapture::ChunkType::Block};
+  std::uint64_t blockIndex{};
+  // block
+  double sampleRate{};
+  int numSamples{};
+  juce::MidiBuffer midi;
+  // topology
+  int event{BlockCapture::fullState};
+  juce::MemoryBlock state;
+};
+
+// Reads back a capture written by `BlockCapture`, one chunk at a time.
+class CaptureReader {
+public:
+  explicit CaptureReader(const juce::File &file);
+
+  [[nodiscard]] bool isValid() const {
+    return valid;
+  }
+
+  bool next(CaptureChunk &chunk);
+
+private:
+  juce::FileInputStream in;
+  bool valid{false};
+  std::vector<std::uint8_t> eventBytes;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CaptureReader)
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+// Places message thread events inside an audio block. Events that arrived since the previous
+// block are spread over the current one in proportion to their arrival time, so they reach the
+// audio one block late but keep their spacing, the way juce::MidiMessageCollector does it.
+struct BlockClock {
+  // audio thread, once per block before calling position()
+  void begin() {
+    auto now = juce::Time::getMillisecondCounterHiRes();
+    m_start = m_end;
+    m_end = now;
+  }
+
+  // sample position in a block of numSamples for an event stamped with `time`
+  [[nodiscard]] int position(double time, int numSamples) const {
+    auto elapsed = m_end - m_start;
+    auto position = m_start > 0.0 && elapsed > 0.0
+                    ? juce::roundToInt((time - m_start) / elapsed * numSamples)
+                    : 0;
+    return juce::jlimit(0, std::max(0, numSamples - 1), position);
+  }
+
+  static double now() {
+    return juce::Time::getMillisecondCounterHiRes();
+  }
+
+private:
+  double m_start{0.0};
+  double m_end{0.0};
+};
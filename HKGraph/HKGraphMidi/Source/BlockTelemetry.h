@@ -0,0 +1,52 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "Histogram.h"
+
+// processBlock wall time and how close each block came to its deadline (the block duration),
+// written by the audio thread and read by the message thread without locking
+struct BlockTelemetry {
+  struct Snapshot {
+    std::uint64_t blocks{};
+    double p50{}; // microseconds
+    double p99{};
+    double max{};
+    std::uint64_t over50{};
+    std::uint64_t over80{};
+    std::uint64_t over100{};
+    std::string slowestNode;
+    double slowestNodeP99{};
+  };
+
+  Histogram blockTime;
+  std::atomic<std::uint64_t> over50{0};
+  std::atomic<std::uint64_t> over80{0};
+  std::atomic<std::uint64_t> over100{0};
+
+  void record(std::uint64_t elapsedNs, std::uint64_t deadlineNs) {
+    blockTime.record(elapsedNs);
+    if (deadlineNs == 0) return;
+    if (elapsedNs * 2 > deadlineNs) over50.fetch_add(1, std::memory_order_relaxed);
+    if (elapsedNs * 5 > deadlineNs * 4) over80.fetch_add(1, std::memory_order_relaxed);
+    if (elapsedNs > deadlineNs) over100.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void reset() {
+    blockTime.reset();
+    over50 = 0;
+    over80 = 0;
+    over100 = 0;
+  }
+
+  [[nodiscard]] Snapshot snapshot() const {
+    Snapshot s;
+    s.blocks = blockTime.count();
+    s.p50 = static_cast<double>(blockTime.percentile(0.5)) / 1000.0;
+    s.p99 = static_cast<double>(blockTime.percentile(0.99)) / 1000.0;
+    s.max = static_cast<double>(blockTime.max()) / 1000.0;
+    s.over50 = over50.load(std::memory_order_relaxed);
+    s.over80 = over80.load(std::memory_order_relaxed);
+    s.over100 = over100.load(std::memory_order_relaxed);
+    return s;
+  }
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <bit>
+#include "Graph.h"
+#include "Processors.h"
+
+// Splits one block into up to 16 outputs, one per out pin order. The buffers are allocated once
+// and reused, pins are looked up once in bind() instead of per block, and outputs that received
+// nothing in a block are not dispatched at all.
+//
+// Usage per block: clear(), add() every event to the output it belongs to, then dispatch().
+struct ChannelDemux {
+  static constexpr int Outputs = 16;
+
+  // resolves output i to the out pin with order i, call again whenever the pins change
+  void bind(std::unordered_map<uuid, Graph::Node::Pin> &outs) {
+    m_pins.fill(nullptr);
+    for (auto &[_, p]: outs) {
+      if (p.m_order < static_cast<std::uint32_t>(Outputs)) {
+        m_pins[p.m_order] = &p;
+      }
+    }
+  }
+
+  void clear() {
+    forEachUsed([this](size_t i) { m_buffers[i].clear(); });
+    m_used = 0;
+  }
+
+  // events for an output without a pin are dropped
+  void add(int output, const juce::uint8 *data, int numBytes, int samplePosition) {
+    auto i = static_cast<size_t>(output);
+    if (i >= m_pins.size() || m_pins[i] == nullptr) return;
+    m_buffers[i].addEvent(data, numBytes, samplePosition);
+    m_used |= static_cast<std::uint32_t>(1u << i);
+  }
+
+  void add(int output, const juce::MidiMessage &message, int samplePosition) {
+    add(output, message.getRawData(), message.getRawDataSize(), samplePosition);
+  }
+
+  void dispatch(Graph *graph, const Block &input) {
+    forEachUsed([this, graph, &input](size_t i) {
+      Data data = std::make_any<Block>(input.audioBuffer, m_buffers[i], input.transport);
+      m_pins[i]->async_dispatch(graph, data);
+    });
+  }
+
+private:
+  template<typename F>
+  void forEachUsed(F &&f) {
+    for (auto used = m_used; used != 0; used &= used - 1) {
+      f(static_cast<size_t>(std::countr_zero(used)));
+    }
+  }
+
+  std::array<EventBuffer, Outputs> m_buffers;
+  std::array<Graph::Node::Pin *, Outputs> m_pins{};
+  std::uint32_t m_used{0};
+};
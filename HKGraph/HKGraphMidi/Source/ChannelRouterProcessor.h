@@ -1,10 +1,14 @@
 #pragma once
 #include "NodeProcessor.h"
 #include "RangeParameter.h"
+#include "RawMidi.h"
 #include "Processors.h"
 
-struct ChannelRouterProcessor : public NodeProcessor {
+struct ChannelRouterProcessor : public NodeProcessor, public AutomatableParameters {
   IntRangeParameter m_parameter;
+  // the channel each sounding input note was sent to, so note-offs follow their note-ons
+  NoteMap m_notes;
+  OncePerBlock m_blocks;
 
   explicit ChannelRouterProcessor(Graph *graph) :
     NodeProcessor(graph),
@@ -19,26 +23,37 @@ struct ChannelRouterProcessor : public NodeProcessor {
 
   ~ChannelRouterProcessor() override = default;
 
+  std::vector<Entry> automatableParameters() override {
+    return {{"channel", &m_parameter}};
+  }
+
   void
   on_data(Graph *graph, const std::optional<const Graph::Node::Pin> &pin, Data &data) override {
     juce::ignoreUnused(pin);
-    auto shift = m_parameter.value;
     auto input = std::any_cast<Block>(data);
-    juce::MidiBuffer output;
-    /////
-    if (m_parameter.changed) {
-      for (auto i = 1; i <= 16; i++) {
-        output.addEvent(juce::MidiMessage::allNotesOff(i), 0);
-      }
-      m_parameter.changed = false;
+    // once per host block, however many times the node is reached
+    if (m_blocks.first(input)) {
+      m_parameter.beginBlock(input.audioBuffer.getNumSamples(), input.hostBlock());
     }
-    /////
-    for (auto m: input.midiBuffer) {
-      auto message = m.getMessage();
-      message.setChannel(shift);
-      output.addEvent(message, m.samplePosition);
-    }
-    Data outputData = std::make_any<Block>(input.audioBuffer, output);
+    input.events.rewrite([this](juce::uint8 *bytes, int size, int samplePosition) {
+      if (!RawMidi::isChannelMessage(bytes, size)) {
+        return true;
+      }
+      auto target = static_cast<std::int8_t>(juce::jlimit(1, 16, m_parameter.valueAt(samplePosition)) - 1);
+      auto channel = target;
+      if (RawMidi::isNoteOn(bytes, size)) {
+        m_notes.set(bytes[0] & 0x0F, bytes[1], target);
+      } else if (RawMidi::isNoteOff(bytes, size)) {
+        auto mapped = m_notes.take(bytes[0] & 0x0F, bytes[1]);
+        channel = mapped == NoteMap::Unknown ? target : mapped;
+      } else if (size == 3 && (bytes[0] & 0xF0) == 0xA0) { // polyphonic aftertouch follows its note
+        auto mapped = m_notes.get(bytes[0] & 0x0F, bytes[1]);
+        channel = mapped == NoteMap::Unknown ? target : mapped;
+      }
+      bytes[0] = static_cast<juce::uint8>((bytes[0] & 0xF0) | channel);
+      return true;
+    });
+    Data outputData = std::make_any<Block>(std::move(input));
     for (auto &[_, p]: m_outs) {
       p.async_dispatch(graph, outputData);
     }
@@ -49,11 +64,11 @@ struct ChannelRouterProcessor : public NodeProcessor {
   }
 
   void saveState(juce::ValueTree& nodeTree) override {
-    nodeTree.setProperty("ChannelRouterProcessor::parameter", juce::var(m_parameter.value), nullptr);
+    nodeTree.setProperty("ChannelRouterProcessor::parameter", juce::var(m_parameter.get()), nullptr);
   }
 
   void restoreState(const juce::ValueTree& nodeTree) override {
-    m_parameter.value = nodeTree.getProperty("ChannelRouterProcessor::parameter");
+    m_parameter.reset(nodeTree.getProperty("ChannelRouterProcessor::parameter"));
   }
 
   NodeProcessor *clone() override {
@@ -64,7 +79,7 @@ struct ChannelRouterProcessor : public NodeProcessor {
         static_cast<std::uint32_t>(m_ins.size()),
         static_cast<std::uint32_t>(m_outs.size()));
     c->m_muted = m_muted;
-    c->m_parameter.value = m_parameter.value;
+    c->m_parameter.reset(m_parameter.get());
     return c;
   }
 
@@ -2,9 +2,11 @@
 
 #include "Graph.h"
 #include "Processors.h"
+#include "ChannelDemux.h"
+#include "RawMidi.h"
 
 struct ChannelSplitterProcessor : public NodeProcessor {
-  std::unordered_map<int, uuid> m_ordered_pins;
+  ChannelDemux m_demux;
 
   explicit ChannelSplitterProcessor(Graph *graph) :
     NodeProcessor(graph) {
@@ -12,9 +14,7 @@ struct ChannelSplitterProcessor : public NodeProcessor {
 
   ChannelSplitterProcessor(Graph *graph, const std::string &name, uint32_t n_ins, uint32_t n_outs)
     : NodeProcessor(graph, name, n_ins, n_outs) {
-    for (auto &[id, p]: m_outs) {
-      m_ordered_pins[static_cast<int>(p.m_order)] = id;
-    }
+    m_demux.bind(m_outs);
   }
 
   ~ChannelSplitterProcessor() override = default;
@@ -22,21 +22,15 @@ struct ChannelSplitterProcessor : public NodeProcessor {
   void
   on_data(Graph *graph, const std::optional<const Node::Pin> &pin, Data &data) override {
     juce::ignoreUnused(pin);
-    auto input = std::any_cast<Block>(data);
-    std::unordered_map<int, juce::MidiBuffer> output;
-    for (auto m: input.midiBuffer) {
-      output[m.getMessage().getChannel() - 1].addEvent(m.getMessage(), m.samplePosition);
-    }
-    for (auto &[index, channelOutput]: output) {
-      auto uuid_ptr = m_ordered_pins.find(index);
-      if (uuid_ptr != std::end(m_ordered_pins)) {
-        auto pin_ptr = m_outs.find(uuid_ptr->second);
-        if (pin_ptr != std::end(m_outs)) {
-          Data channelData = std::make_any<Block>(input.audioBuffer, channelOutput);
-          pin_ptr->second.async_dispatch(graph, channelData);
-        }
+    auto const &input = std::any_cast<const Block &>(data);
+    m_demux.clear();
+    for (auto m: input.events) {
+      // system messages have no channel and go nowhere
+      if (RawMidi::isChannelMessage(m.data, m.numBytes)) {
+        m_demux.add(m.data[0] & 0x0F, m.data, m.numBytes, m.samplePosition);
       }
     }
+    m_demux.dispatch(graph, input);
   }
 
   [[nodiscard]] std::string typeId() const override {
@@ -49,9 +43,7 @@ struct ChannelSplitterProcessor : public NodeProcessor {
 
   void restoreState(const juce::ValueTree& nodeTree) override {
     juce::ignoreUnused(nodeTree);
-    for (auto &[id, p]: m_outs) {
-      m_ordered_pins[static_cast<int>(p.m_order)] = id;
-    }
+    m_demux.bind(m_outs);
   }
 
   NodeProcessor *clone() override {
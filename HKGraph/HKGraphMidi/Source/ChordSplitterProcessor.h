@@ -3,9 +3,12 @@
 #include "Graph.h"
 #include "Processors.h"
 #include "NodeProcessor.h"
+#include "ChannelDemux.h"
+#include "VoiceAllocator.h"
 
 struct ChordSplitterProcessor : public NodeProcessor {
-  std::unordered_map<int, uuid> m_ordered_pins;
+  ChannelDemux m_demux;
+  VoiceAllocator m_voices;
 
   explicit ChordSplitterProcessor(Graph *graph) :
     NodeProcessor(graph) {
@@ -13,9 +16,7 @@ struct ChordSplitterProcessor : public NodeProcessor {
 
   ChordSplitterProcessor(Graph *graph, const std::string &name, uint32_t n_ins, uint32_t n_outs)
     : NodeProcessor(graph, name, n_ins, n_outs) {
-    for (auto &[id, p]: m_outs) {
-      m_ordered_pins[static_cast<int>(p.m_order)] = id;
-    }
+    bindOutputs();
   }
 
   ~ChordSplitterProcessor() override = default;
@@ -23,37 +24,10 @@ struct ChordSplitterProcessor : public NodeProcessor {
   void
   on_data(Graph *graph, const std::optional<const Node::Pin> &pin, Data &data) override {
     juce::ignoreUnused(pin);
-    auto input = std::any_cast<Block>(data);
-    std::unordered_map<int, juce::MidiBuffer> output;
-    std::vector<juce::MidiMessageMetadata> sorted;
-    for (auto m: input.midiBuffer) {
-      sorted.push_back(m);
-    }
-
-    std::sort(sorted.begin(), sorted.end(), [&](auto &l, auto &r) {
-      return l.getMessage().getNoteNumber() < r.getMessage().getNoteNumber();
-    });
-
-    auto i = 0;
-    for (auto &m : sorted) {
-      auto message = m.getMessage();
-      message.setChannel(i + 1);
-      output[i].addEvent(message, m.samplePosition);
-      ++i;
-
-      if (i > 15) i = 0;
-    }
-
-    for (auto &[index, channelOutput]: output) {
-      auto uuid_ptr = m_ordered_pins.find(index);
-      if (uuid_ptr != std::end(m_ordered_pins)) {
-        auto pin_ptr = m_outs.find(uuid_ptr->second);
-        if (pin_ptr != std::end(m_outs)) {
-          Data channelData = std::make_any<Block>(input.audioBuffer, channelOutput);
-          pin_ptr->second.async_dispatch(graph, channelData);
-        }
-      }
-    }
+    auto const &input = std::any_cast<const Block &>(data);
+    m_demux.clear();
+    m_voices.process(input.events, m_demux);
+    m_demux.dispatch(graph, input);
   }
 
   [[nodiscard]] std::string typeId() const override {
@@ -66,9 +40,7 @@ struct ChordSplitterProcessor : public NodeProcessor {
 
   void restoreState(const juce::ValueTree& nodeTree) override {
     juce::ignoreUnused(nodeTree);
-    for (auto &[id, p]: m_outs) {
-      m_ordered_pins[static_cast<int>(p.m_order)] = id;
-    }
+    bindOutputs();
   }
 
   NodeProcessor *clone() override {
@@ -85,4 +57,10 @@ struct ChordSplitterProcessor : public NodeProcessor {
     juce::ignoreUnused(theme);
     return nullptr;
   }
+
+private:
+  void bindOutputs() {
+    m_demux.bind(m_outs);
+    m_voices.setNumVoices(static_cast<int>(m_outs.size()));
+  }
 };
\ No newline at end of file
@@ -1,20 +1,20 @@
 #pragma once
 
-#include "NodeProcessor.h"
+#include "EventProcessor.h"
 #include "CurveEditor.h"
 #include "Processors.h"
 
-struct CurveProcessor : public NodeProcessor {
+struct CurveProcessor : public EventProcessor {
 
   ce::CurveEditorModel<float> model;
 
   CurveProcessor(Graph *graph, const std::string &name, uint32_t n_ins, uint32_t n_outs,
                  ce::CurveEditorModel<float> &&curveEditorModel)
-    : NodeProcessor(graph, name, n_ins, n_outs),
+    : EventProcessor(graph, name, n_ins, n_outs),
       model(std::move(curveEditorModel)) {}
 
   explicit CurveProcessor(Graph *graph, ce::CurveEditorModel<float> &&curveEditorModel) :
-    NodeProcessor(graph),
+    EventProcessor(graph),
     model(std::move(curveEditorModel)) {}
 
   ~CurveProcessor() override = default;
@@ -42,24 +42,29 @@ struct VelocityCurveProcessor : CurveProcessor {
   explicit VelocityCurveProcessor(Graph *graph) :
     CurveProcessor(graph, ce::CurveEditorModel<float>(0.0f, 127.0f, 0.0f, 127.0f)) {}
 
-  void
-  on_data(Graph *graph, const std::optional<const Graph::Node::Pin> &pin, Data &data) override {
+  EventSubscription subscription(const std::optional<const Node::Pin> &pin) const override {
     juce::ignoreUnused(pin);
-    auto input = std::any_cast<Block>(data);
-    juce::MidiBuffer output;
-    for (auto m: input.midiBuffer) {
-      auto message = m.getMessage();
-      auto velocity = message.getVelocity(); // [0..127]
-      auto computed = model.compute(velocity);
-      auto scaled = computed / 127.0f;
-      scaled = std::min(scaled, 1.0f);
-      message.setVelocity(scaled);
-      output.addEvent(message, m.samplePosition);
+    return EventSubscription::notes();
+  }
+
+  bool processEvent(juce::uint8 *bytes, int size, int samplePosition) override {
+    juce::ignoreUnused(samplePosition);
+    if (size != 3) {
+      return true;
+    }
+    auto isNoteOn = (bytes[0] & 0xF0) == 0x90;
+    auto velocity = bytes[2]; // [0..127]
+    if (isNoteOn && velocity == 0) {
+      return true; // note-off written as a note-on with velocity 0
     }
-    Data result = std::make_any<Block>(input.audioBuffer, output);
-    for (auto &[_, p]: m_outs) {
-      p.on_data(graph, result);
+    auto computed = juce::jlimit(0, 127, juce::roundToInt(model.lookup(velocity)));
+    if (isNoteOn) {
+      model.lastInput->write(static_cast<float>(velocity));
+      // a note-on must not turn into a note-off
+      computed = std::max(computed, 1);
     }
+    bytes[2] = static_cast<juce::uint8>(computed);
+    return true;
   }
 
   [[nodiscard]] std::string typeId() const override {
@@ -94,27 +99,20 @@ struct ControllerCurveProcessor : CurveProcessor {
   explicit ControllerCurveProcessor(Graph *graph) :
     CurveProcessor(graph, ce::CurveEditorModel<float>(0.0f, 127.0f, 0.0f, 127.0f)) {}
 
-  void
-  on_data(Graph *graph, const std::optional<const Graph::Node::Pin> &pin, Data &data) override {
+  EventSubscription subscription(const std::optional<const Node::Pin> &pin) const override {
     juce::ignoreUnused(pin);
-    auto input = std::any_cast<Block>(data);
-    juce::MidiBuffer output;
-    for (auto m: input.midiBuffer) {
-      auto message = m.getMessage();
-      if (message.isControllerOfType(controllerType)) {
-        auto value = message.getControllerValue(); // [0..127]
-        auto computed = static_cast<int>(model.compute(static_cast<float>(value)));
-        auto out = juce::MidiMessage::controllerEvent(message.getChannel(), controllerType, computed);
-        output.addEvent(out, m.samplePosition);
-      }
-      else {
-        output.addEvent(message, m.samplePosition);
-      }
-    }
-    Data result = std::make_any<Block>(input.audioBuffer, output);
-    for (auto &[_, p]: m_outs) {
-      p.on_data(graph, result);
+    return EventSubscription::controllerNumber(controllerType);
+  }
+
+  bool processEvent(juce::uint8 *bytes, int size, int samplePosition) override {
+    juce::ignoreUnused(samplePosition);
+    if (size == 3) {
+      auto value = bytes[2]; // [0..127]
+      auto computed = juce::jlimit(0, 127, static_cast<int>(model.lookup(value)));
+      model.lastInput->write(static_cast<float>(value));
+      bytes[2] = static_cast<juce::uint8>(computed);
     }
+    return true;
   }
 
   [[nodiscard]] std::string typeId() const override {
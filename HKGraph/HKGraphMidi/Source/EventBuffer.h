@@ -0,0 +1,267 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+// One block's events decoded into columns, one array per field, so a node that looks at every
+// event reads plain arrays instead of parsing message bytes. Filled by EventBuffer::decode.
+//
+// The host's block is decoded once, into columns the processor owns, and every node reading the
+// block unchanged shares them (see EventBuffer::decodeShared). A node that gets edited events
+// decodes into columns of its own. Columns are reserved for ReservedEvents when they are built, so
+// decoding on the audio thread does not allocate unless a block holds more events than that, the
+// same bound EventBuffer reserves for itself.
+struct EventColumns {
+  static constexpr size_t ReservedEvents = 256;
+
+  // bit flags of the kind column
+  enum Kind : juce::uint8 {
+    noteOn = 1,
+    noteOff = 2, // including note-on with velocity 0
+  };
+
+  std::vector<std::int32_t> time;
+  // status with the channel masked off, system messages keep their full status
+  std::vector<juce::uint8> type;
+  // 0-based, 0 for system messages
+  std::vector<juce::uint8> channel;
+  std::vector<juce::uint8> data1;
+  std::vector<juce::uint8> data2;
+  std::vector<juce::uint8> kind;
+
+  EventColumns() {
+    time.reserve(ReservedEvents);
+    type.reserve(ReservedEvents);
+    channel.reserve(ReservedEvents);
+    data1.reserve(ReservedEvents);
+    data2.reserve(ReservedEvents);
+    kind.reserve(ReservedEvents);
+  }
+
+  void resize(size_t n) {
+    time.resize(n);
+    type.resize(n);
+    channel.resize(n);
+    data1.resize(n);
+    data2.resize(n);
+    kind.resize(n);
+  }
+
+  [[nodiscard]] size_t size() const {
+    return time.size();
+  }
+
+  // classifies every event in one pass over the columns, written without branches so it vectorises
+  void classify() {
+    for (size_t i = 0; i < kind.size(); ++i) {
+      auto isOn = static_cast<juce::uint8>(type[i] == 0x90) & static_cast<juce::uint8>(data2[i] != 0);
+      auto isOff = static_cast<juce::uint8>(type[i] == 0x80) |
+                   (static_cast<juce::uint8>(type[i] == 0x90) & static_cast<juce::uint8>(data2[i] == 0));
+      kind[i] = static_cast<juce::uint8>(isOn | (isOff << 1));
+    }
+  }
+};
+
+// The MIDI events of one block as they travel through the graph.
+//
+// Every event is 8 bytes: its sample position and up to three message bytes, in the spirit of a
+// MIDI 2.0 universal packet. Walking a block never decodes variable length headers, and events
+// are appended in time order, an out of order add falls back to an insert. SysEx does not fit in
+// an event, its bytes go to a side arena and the event keeps an index to them.
+//
+// Conversion from and to juce::MidiBuffer happens at the graph's edges only, in
+// MidiInNodeProcessor and MidiOutNodeProcessor.
+//
+// decode fills an EventColumns the caller owns, nothing is allocated per buffer. decodeShared also
+// remembers them, so the buffer and its copies hand them out through decoded() until the events
+// change. A node that only needs to look at a few fields can walk the buffer instead.
+class EventBuffer {
+public:
+  struct Event {
+    std::int32_t time;
+    std::array<juce::uint8, 3> bytes;
+    // 1 to 3 for a short message, 0 when bytes[1..2] hold the index of a SysEx span
+    juce::uint8 size;
+  };
+  static_assert(sizeof(Event) == 8);
+
+  class Iterator {
+  public:
+    Iterator(const EventBuffer &owner, const Event *event) : m_owner(&owner), m_event(event) {}
+
+    juce::MidiMessageMetadata operator*() const {
+      return {m_owner->getData(*m_event), m_owner->getSize(*m_event), m_event->time};
+    }
+
+    Iterator &operator++() {
+      ++m_event;
+      return *this;
+    }
+
+    bool operator==(const Iterator &other) const {
+      return m_event == other.m_event;
+    }
+
+    bool operator!=(const Iterator &other) const {
+      return m_event != other.m_event;
+    }
+
+  private:
+    const EventBuffer *m_owner;
+    const Event *m_event;
+  };
+
+  static constexpr size_t ReservedEvents = EventColumns::ReservedEvents;
+
+  EventBuffer() {
+    m_events.reserve(ReservedEvents);
+  }
+
+  void clear() {
+    m_decoded = nullptr;
+    m_events.clear();
+    m_arena.clear();
+    m_sysex.clear();
+  }
+
+  [[nodiscard]] bool isEmpty() const {
+    return m_events.empty();
+  }
+
+  [[nodiscard]] int getNumEvents() const {
+    return static_cast<int>(m_events.size());
+  }
+
+  [[nodiscard]] Iterator begin() const {
+    return {*this, m_events.data()};
+  }
+
+  [[nodiscard]] Iterator end() const {
+    return {*this, m_events.data() + m_events.size()};
+  }
+
+  [[nodiscard]] juce::MidiMessageMetadata getEvent(size_t index) const {
+    auto const &event = m_events[index];
+    return {getData(event), getSize(event), event.time};
+  }
+
+  // decodes every event into columns, reusing their storage
+  void decode(EventColumns &columns) const {
+    auto n = m_events.size();
+    columns.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      auto const &event = m_events[i];
+      // a SysEx event has size 0 and 0xF0 in its first byte, its data bytes are an index
+      auto status = event.bytes[0];
+      auto isSystem = static_cast<juce::uint8>(status >= 0xF0);
+      auto hasData1 = static_cast<juce::uint8>(event.size > 1);
+      auto hasData2 = static_cast<juce::uint8>(event.size > 2);
+      columns.time[i] = event.time;
+      columns.type[i] = static_cast<juce::uint8>(status & (isSystem ? 0xFF : 0xF0));
+      columns.channel[i] = static_cast<juce::uint8>((status & 0x0F) * (1 - isSystem));
+      columns.data1[i] = static_cast<juce::uint8>(event.bytes[1] * hasData1);
+      columns.data2[i] = static_cast<juce::uint8>(event.bytes[2] * hasData2);
+    }
+    columns.classify();
+  }
+
+  // decodes into columns that outlive the buffer's dispatch, and shares them with every copy
+  void decodeShared(EventColumns &columns) {
+    decode(columns);
+    m_decoded = &columns;
+  }
+
+  // the shared columns if the events did not change since decodeShared, otherwise decodes into fallback
+  [[nodiscard]] const EventColumns &decoded(EventColumns &fallback) const {
+    if (m_decoded != nullptr) return *m_decoded;
+    decode(fallback);
+    return fallback;
+  }
+
+  void addEvent(const juce::uint8 *data, int size, int time) {
+    if (size <= 0) return;
+    m_decoded = nullptr;
+    Event event{time, {}, 0};
+    if (size <= 3) {
+      std::copy_n(data, size, event.bytes.begin());
+      event.size = static_cast<juce::uint8>(size);
+    } else {
+      if (m_sysex.size() > 0xFFFF) return; // no index left, the block is flooded anyway
+      auto index = m_sysex.size();
+      m_sysex.push_back({static_cast<std::uint32_t>(m_arena.size()), static_cast<std::uint32_t>(size)});
+      m_arena.insert(m_arena.end(), data, data + size);
+      event.bytes = {0xF0, static_cast<juce::uint8>(index & 0xFF), static_cast<juce::uint8>(index >> 8)};
+    }
+    if (m_events.empty() || m_events.back().time <= time) {
+      m_events.push_back(event);
+    } else {
+      auto itr = std::upper_bound(m_events.begin(), m_events.end(), time, [](int t, const Event &e) {
+        return t < e.time;
+      });
+      m_events.insert(itr, event);
+    }
+  }
+
+  void addEvent(const juce::MidiMessage &message, int time) {
+    addEvent(message.getRawData(), message.getRawDataSize(), time);
+  }
+
+  void addEvents(const EventBuffer &other) {
+    for (auto m: other) {
+      addEvent(m.data, m.numBytes, m.samplePosition);
+    }
+  }
+
+  void addEvents(const juce::MidiBuffer &buffer) {
+    for (auto m: buffer) {
+      addEvent(m.data, m.numBytes, m.samplePosition);
+    }
+  }
+
+  void copyTo(juce::MidiBuffer &buffer) const {
+    for (auto m: *this) {
+      buffer.addEvent(m.data, m.numBytes, m.samplePosition);
+    }
+  }
+
+  // Calls f(bytes, numBytes, samplePosition) for every event. f may rewrite the bytes in place
+  // but not change their count, and returns false to drop the event. Kept events are compacted
+  // in the same pass and keep their order.
+  template<typename F>
+  void rewrite(F &&f) {
+    m_decoded = nullptr;
+    auto write = m_events.begin();
+    for (auto read = m_events.begin(); read != m_events.end(); ++read) {
+      if (f(getData(*read), getSize(*read), static_cast<int>(read->time))) {
+        *write++ = *read;
+      }
+    }
+    m_events.erase(write, m_events.end());
+  }
+
+private:
+  struct Span {
+    std::uint32_t offset, size;
+  };
+
+  [[nodiscard]] const Span &span(const Event &event) const {
+    return m_sysex[static_cast<size_t>(event.bytes[1] | (event.bytes[2] << 8))];
+  }
+
+  [[nodiscard]] const juce::uint8 *getData(const Event &event) const {
+    return event.size > 0 ? event.bytes.data() : m_arena.data() + span(event).offset;
+  }
+
+  juce::uint8 *getData(Event &event) {
+    return event.size > 0 ? event.bytes.data() : m_arena.data() + span(event).offset;
+  }
+
+  [[nodiscard]] int getSize(const Event &event) const {
+    return event.size > 0 ? event.size : static_cast<int>(span(event).size);
+  }
+
+  std::vector<Event> m_events;
+  std::vector<juce::uint8> m_arena;
+  std::vector<Span> m_sysex;
+  // owned by whoever called decodeShared, valid while the block is dispatched
+  const EventColumns *m_decoded{nullptr};
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "NodeProcessor.h"
+#include "Processors.h"
+#include "EventSubscription.h"
+
+// A node that transforms events one at a time and only cares about some of them.
+//
+// Each in-pin declares a subscription. A block with nothing the pin subscribes to is forwarded
+// as is, without a copy. Otherwise only the subscribed events reach processEvent, the others
+// stay where they are, so the output keeps the input's order.
+struct EventProcessor : public NodeProcessor {
+  using NodeProcessor::NodeProcessor;
+
+  ~EventProcessor() override = default;
+
+  virtual EventSubscription subscription(const std::optional<const Node::Pin> &pin) const {
+    juce::ignoreUnused(pin);
+    return EventSubscription::all();
+  }
+
+  // called once per host block, before any of its events and whether or not the node gets some.
+  // A node reached again in the same block (several in-pins, fan-in) does not get it again.
+  virtual void beginBlock(const Block &block) {
+    juce::ignoreUnused(block);
+  }
+
+  // same contract as EventBuffer::rewrite: edit the bytes in place, return false to drop the event
+  virtual bool processEvent(juce::uint8 *bytes, int size, int samplePosition) = 0;
+
+  void
+  on_data(Graph *graph, const std::optional<const Node::Pin> &pin, Data &data) override {
+    auto const &input = std::any_cast<const Block &>(data);
+    if (m_blocks.first(input)) {
+      beginBlock(input);
+    }
+    auto wanted = subscription(pin);
+    if (!wanted.isAll()) {
+      if (wanted.select(input.events.decoded(m_columns), m_selected) == 0) {
+        dispatch(graph, data);
+        return;
+      }
+    }
+    auto output = input;
+    size_t i = 0;
+    output.events.rewrite([&](juce::uint8 *bytes, int size, int samplePosition) {
+      auto taken = wanted.isAll() || m_selected[i] != 0;
+      ++i;
+      return !taken || processEvent(bytes, size, samplePosition);
+    });
+    Data result = std::make_any<Block>(std::move(output));
+    dispatch(graph, result);
+  }
+
+private:
+  void dispatch(Graph *graph, Data &data) {
+    for (auto &[_, p]: m_outs) {
+      p.async_dispatch(graph, data);
+    }
+  }
+
+  OncePerBlock m_blocks;
+  // for blocks that were edited on their way here, see EventColumns
+  EventColumns m_columns;
+  std::vector<juce::uint8> m_selected = std::vector<juce::uint8>(EventColumns::ReservedEvents);
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "EventBuffer.h"
+
+// The events an in-pin wants: a set of message types, a set of channels and, for controller
+// messages, a set of controller numbers. System messages ignore the channel set.
+struct EventSubscription {
+  // one bit per status nibble 0x8 to 0xE, bit 7 for every system message
+  std::uint16_t types{0xFF};
+  std::uint16_t channels{0xFFFF};
+  std::array<std::uint64_t, 2> controllers{~std::uint64_t{0}, ~std::uint64_t{0}};
+
+  static constexpr std::uint16_t noteOff = 1 << 0;
+  static constexpr std::uint16_t noteOn = 1 << 1;
+  static constexpr std::uint16_t polyPressure = 1 << 2;
+  static constexpr std::uint16_t controller = 1 << 3;
+  static constexpr std::uint16_t programChange = 1 << 4;
+  static constexpr std::uint16_t channelPressure = 1 << 5;
+  static constexpr std::uint16_t pitchBend = 1 << 6;
+  static constexpr std::uint16_t system = 1 << 7;
+
+  static EventSubscription all() {
+    return {};
+  }
+
+  static EventSubscription ofTypes(std::uint16_t types) {
+    EventSubscription s;
+    s.types = types;
+    return s;
+  }
+
+  static EventSubscription notes() {
+    return ofTypes(noteOff | noteOn);
+  }
+
+  static EventSubscription controllerNumber(int number) {
+    auto s = ofTypes(controller);
+    s.controllers = {};
+    if (number >= 0 && number < 128) {
+      s.controllers[static_cast<size_t>(number / 64)] = std::uint64_t{1} << (number % 64);
+    }
+    return s;
+  }
+
+  [[nodiscard]] bool isAll() const {
+    return types == 0xFF && channels == 0xFFFF && (controllers[0] & controllers[1]) == ~std::uint64_t{0};
+  }
+
+  // Sets selected[i] to 1 for every event this subscription takes and 0 for the rest, returns how
+  // many were taken. Works on the decoded columns without branches so it vectorises.
+  size_t select(const EventColumns &columns, std::vector<juce::uint8> &selected) const {
+    auto n = columns.size();
+    selected.resize(n);
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+      auto type = columns.type[i];
+      auto data1 = columns.data1[i] & 0x7F;
+      auto isSystem = static_cast<unsigned>(type >= 0xF0);
+      auto typeBit = (types >> ((type >> 4) & 7)) & 1u;
+      auto channelBit = ((channels >> columns.channel[i]) & 1u) | isSystem;
+      auto controllerBit = ((controllers[static_cast<size_t>(data1 / 64)] >> (data1 % 64)) & 1u) |
+                           static_cast<unsigned>(type != 0xB0);
+      auto take = static_cast<juce::uint8>(typeBit & channelBit & controllerBit);
+      selected[i] = take;
+      count += take;
+    }
+    return count;
+  }
+};
@@ -15,27 +15,41 @@
 #include "NoteFilterProcessor.h"
 #include "ChordSplitterProcessor.h"
 #include "GraphLookAndFeel.h"
+#include "MacroBank.h"
+#include "TelemetrySlot.h"
 #include "pr/PianoRollProcessor.h"
 
-struct SliderBinding : public juce::Slider::Listener {
+// Edits a parameter with a slider, and follows the parameter when something else moves it (host
+// automation through a macro), except while the slider is being dragged.
+struct SliderBinding : public juce::Slider::Listener, private TelemetryPoller::Client {
   juce::Slider &m_slider;
   IntRangeParameter &m_parameter;
 
   SliderBinding(juce::Slider &slider, IntRangeParameter &parameter)
     : m_slider(slider), m_parameter(parameter) {
     m_slider.setRange(m_parameter.min, m_parameter.max, m_parameter.step);
-    m_slider.setValue(m_parameter.value);
+    m_slider.setValue(m_parameter.get());
     m_slider.addListener(this);
+    m_poller->add(this);
   }
 
   ~SliderBinding() override {
+    m_poller->remove(this);
     m_slider.removeListener(this);
   }
 
   void sliderValueChanged(juce::Slider *slider) override {
-    m_parameter.value = static_cast<int>(slider->getValue());
-    m_parameter.changed = true;
+    m_parameter.set(static_cast<int>(slider->getValue()));
   }
+
+private:
+  void poll() override {
+    auto value = m_parameter.get();
+    if (m_slider.isMouseButtonDown() || value == static_cast<int>(m_slider.getValue())) return;
+    m_slider.setValue(value, juce::dontSendNotification);
+  }
+
+  juce::SharedResourcePointer<TelemetryPoller> m_poller;
 };
 
 struct SliderPanel : public juce::Component {
@@ -76,13 +90,13 @@ private:
 struct KeyboardPanel : public ConstrainedComponent {
   KeyboardProcessor *processor;
   GraphViewTheme theme;
-  juce::MidiKeyboardComponent keyboardComponent;
+  MirroredKeyboardComponent keyboardComponent;
 
   KeyboardPanel(KeyboardProcessor *p, const GraphViewTheme &viewTheme)
     : ConstrainedComponent(),
       processor(p),
       theme(viewTheme),
-      keyboardComponent(p->keyboardState, juce::MidiKeyboardComponent::Orientation::horizontalKeyboard) {
+      keyboardComponent(p->keyboardState, p->sounding, juce::MidiKeyboardComponent::Orientation::horizontalKeyboard) {
     m_constrains.setMinimumSize(400, 100);
     m_constrains.setMaximumHeight(100);
     addAndMakeVisible(keyboardComponent);
@@ -104,6 +118,10 @@ private:
 };
 
 struct GraphEditor : public GraphViewComponent {
+  std::function<bool()> isCapturing;
+  std::function<void()> toggleCapture;
+  std::function<void()> resetTelemetry;
+  MacroBank *macros{nullptr};
 
   explicit GraphEditor(Graph *g) : GraphViewComponent(g) {
   }
@@ -122,6 +140,17 @@ struct GraphEditor : public GraphViewComponent {
     m.addItem(7, "velocity-curve");
     m.addItem(8, "cc-curve");
     m.addItem(9, "piano-roll");
+    if (toggleCapture != nullptr) {
+      m.addSeparator();
+      m.addItem(100, "capture blocks", true, isCapturing != nullptr && isCapturing());
+    }
+    if (resetTelemetry != nullptr) {
+      m.addItem(101, "reset telemetry");
+    }
+    if (macros != nullptr) {
+      m.addSeparator();
+      m.addSubMenu("macros", macrosMenu());
+    }
     auto selection = [&](int result) {
       auto position = getMouseXYRelative().toFloat();
       switch (result) {
@@ -164,10 +193,47 @@ struct GraphEditor : public GraphViewComponent {
             PianoRollProcessor::MIN_HEIGHT,
             position);
           break;
+        case 100:
+          toggleCapture();
+          break;
+        case 101:
+          resetTelemetry();
+          break;
         default:
           break;
       }
     };
     m.showMenuAsync(juce::PopupMenu::Options().withMousePosition(), selection);
   }
+
+  // one submenu per host macro, listing every node parameter it can be bound to
+  juce::PopupMenu macrosMenu() {
+    juce::PopupMenu menu;
+    for (auto slot{0}; slot < MacroBank::Slots; ++slot) {
+      auto const &binding = macros->binding(slot);
+      juce::PopupMenu slotMenu;
+      slotMenu.addItem("unbind", binding.has_value(), false, [this, slot]() { macros->unbind(slot); });
+      slotMenu.addSeparator();
+      juce::String bound;
+      for (auto const &[id, node]: graph->m_nodes) {
+        auto automatable = dynamic_cast<AutomatableParameters *>(node);
+        if (automatable == nullptr) continue;
+        for (auto const &entry: automatable->automatableParameters()) {
+          auto label = juce::String(node->m_name) + " / " + entry.id;
+          auto ticked = binding.has_value() && binding->nodeId == id && binding->parameterId == entry.id;
+          if (ticked) bound = label;
+          // the node may be gone by the time the menu item is picked
+          slotMenu.addItem(label, true, ticked, [this, slot, nodeId = id, parameterId = entry.id]() {
+            auto itr = graph->m_nodes.find(nodeId);
+            if (itr != std::end(graph->m_nodes)) {
+              macros->bind(slot, itr->second, parameterId);
+            }
+          });
+        }
+      }
+      auto title = "macro " + juce::String(slot + 1);
+      menu.addSubMenu(bound.isEmpty() ? title : title + ": " + bound, slotMenu);
+    }
+    return menu;
+  }
 };
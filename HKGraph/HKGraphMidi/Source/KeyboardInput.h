@@ -0,0 +1,154 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "TelemetrySlot.h"
+#include "EventBuffer.h"
+#include "RawMidi.h"
+
+// A key pressed or released on an on-screen keyboard, stamped on the message thread.
+struct KeyEvent {
+  double time; // BlockClock::now
+  std::array<juce::uint8, 3> bytes;
+};
+
+// Hands key events from the message thread to the audio thread. Single producer, single
+// consumer, both sides are wait-free.
+//
+// When the audio thread stops draining it (no audio, node not wired), the queue fills up. Every
+// note-on that got in keeps a slot free for its note-off, so new note-ons are dropped first and
+// no note is left stuck once audio resumes. The note-off of a dropped note-on is dropped too.
+struct KeyEventQueue {
+  static constexpr int Capacity = 256;
+
+  // message thread
+  bool push(const KeyEvent &event) {
+    auto bytes = event.bytes.data();
+    auto note = static_cast<size_t>(bytes[1] & 0x7F);
+    auto &word = m_held[note / 64];
+    auto bit = std::uint64_t{1} << (note % 64);
+    if (RawMidi::isNoteOn(bytes, 3)) {
+      // room for this note-on, and for the note-offs of every note held so far and of this one
+      auto isNew = (word & bit) == 0;
+      if (m_fifo.getFreeSpace() < m_numHeld + (isNew ? 2 : 1) || !write(event)) return false;
+      if (isNew) ++m_numHeld;
+      word |= bit;
+      return true;
+    }
+    if (RawMidi::isNoteOff(bytes, 3)) {
+      if ((word & bit) == 0) return false;
+      word &= ~bit;
+      --m_numHeld;
+    }
+    return write(event);
+  }
+
+  // audio thread, calls f for every queued event in order
+  template<typename F>
+  void pop(F &&f) {
+    auto scope = m_fifo.read(m_fifo.getNumReady());
+    for (auto i{0}; i < scope.blockSize1; ++i) {
+      f(m_events[static_cast<size_t>(scope.startIndex1 + i)]);
+    }
+    for (auto i{0}; i < scope.blockSize2; ++i) {
+      f(m_events[static_cast<size_t>(scope.startIndex2 + i)]);
+    }
+  }
+
+private:
+  bool write(const KeyEvent &event) {
+    auto scope = m_fifo.write(1);
+    if (scope.blockSize1 == 0) return false;
+    m_events[static_cast<size_t>(scope.startIndex1)] = event;
+    return true;
+  }
+
+  juce::AbstractFifo m_fifo{Capacity};
+  std::array<KeyEvent, Capacity> m_events{};
+  // message thread, notes whose note-on is queued or delivered and whose note-off is not
+  std::array<std::uint64_t, 2> m_held{};
+  int m_numHeld{0};
+};
+
+// The notes a keyboard node is passing through, one bit per note on any channel. Written by the
+// audio thread once per block when something changed, read by the keyboard display.
+struct NoteMirror {
+  using Bits = std::array<std::uint64_t, 2>;
+
+  // audio thread, returns true if any note changed. Walks the events in place, nothing is allocated.
+  bool update(const EventBuffer &events) {
+    auto bits = m_local;
+    for (auto m: events) {
+      auto on = RawMidi::isNoteOn(m.data, m.numBytes);
+      if (!on && !RawMidi::isNoteOff(m.data, m.numBytes)) continue;
+      auto note = m.data[1] & 0x7F;
+      auto mask = std::uint64_t{1} << (note % 64);
+      auto &word = bits[static_cast<size_t>(note / 64)];
+      if (on) {
+        word |= mask;
+      } else {
+        word &= ~mask;
+      }
+    }
+    if (bits == m_local) return false;
+    m_local = bits;
+    m_bits[0].store(bits[0], std::memory_order_relaxed);
+    m_bits[1].store(bits[1], std::memory_order_relaxed);
+    m_version.fetch_add(1, std::memory_order_release);
+    return true;
+  }
+
+  [[nodiscard]] bool test(int note) const {
+    if (note < 0 || note > 127) return false;
+    auto word = m_bits[static_cast<size_t>(note / 64)].load(std::memory_order_relaxed);
+    return (word >> (note % 64)) & 1;
+  }
+
+  [[nodiscard]] std::uint32_t version() const {
+    return m_version.load(std::memory_order_acquire);
+  }
+
+private:
+  Bits m_local{};
+  std::array<std::atomic<std::uint64_t>, 2> m_bits{};
+  std::atomic<std::uint32_t> m_version{0};
+};
+
+// A MidiKeyboardComponent that also shows the notes of a NoteMirror as pressed. Clicks still go
+// to the component's MidiKeyboardState, which is only ever touched on the message thread.
+struct MirroredKeyboardComponent : public juce::MidiKeyboardComponent, private TelemetryPoller::Client {
+  MirroredKeyboardComponent(juce::MidiKeyboardState &state, const NoteMirror &noteMirror, Orientation orientation)
+    : juce::MidiKeyboardComponent(state, orientation), m_mirror(noteMirror) {
+    m_poller->add(this);
+  }
+
+  ~MirroredKeyboardComponent() override {
+    m_poller->remove(this);
+  }
+
+  void drawWhiteNote(int midiNoteNumber, juce::Graphics &g, juce::Rectangle<float> area, bool isDown, bool isOver,
+                     juce::Colour lineColour, juce::Colour textColour) override {
+    juce::MidiKeyboardComponent::drawWhiteNote(midiNoteNumber, g, area, isDown || m_mirror.test(midiNoteNumber),
+                                               isOver, lineColour, textColour);
+  }
+
+  void drawBlackNote(int midiNoteNumber, juce::Graphics &g, juce::Rectangle<float> area, bool isDown, bool isOver,
+                     juce::Colour noteFillColour) override {
+    juce::MidiKeyboardComponent::drawBlackNote(midiNoteNumber, g, area, isDown || m_mirror.test(midiNoteNumber),
+                                               isOver, noteFillColour);
+  }
+
+private:
+  void poll() override {
+    auto version = m_mirror.version();
+    if (version != m_version) {
+      m_version = version;
+      repaint();
+    }
+  }
+
+  const NoteMirror &m_mirror;
+  std::uint32_t m_version{0};
+  juce::SharedResourcePointer<TelemetryPoller> m_poller;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MirroredKeyboardComponent)
+};
@@ -3,49 +3,39 @@
 #include "Processors.h"
 #include "NodeProcessor.h"
 #include "PlaybackProcessor.h"
+#include "KeyboardInput.h"
+#include "BlockClock.h"
 
-struct KeyboardProcessor : public PlaybackProcessor {
+// A node with an on-screen keyboard. Keys clicked on screen travel to the audio thread through a
+// wait-free queue, and the notes passing through are mirrored back for display, so the audio
+// thread never takes a lock shared with the UI.
+struct KeyboardProcessor : public PlaybackProcessor, private juce::MidiKeyboardState::Listener {
+  // message thread only, holds the keys pressed on screen
   juce::MidiKeyboardState keyboardState{};
-  juce::MidiMessageCollector keyboardMessageCollector;
-  bool hasCalledReset{false};
+  KeyEventQueue keyEvents;
+  NoteMirror sounding;
 
   explicit KeyboardProcessor(Graph *graph) :
     PlaybackProcessor(graph) {
-    keyboardMessageCollector.reset(512);
-    hasCalledReset = true;
-    keyboardState.addListener(&keyboardMessageCollector);
+    keyboardState.addListener(this);
   }
 
   KeyboardProcessor(Graph *graph, const std::string &name, uint32_t n_ins, uint32_t n_outs)
     : PlaybackProcessor(graph, name, n_ins, n_outs) {
-    keyboardMessageCollector.reset(512);
-    hasCalledReset = true;
-    keyboardState.addListener(&keyboardMessageCollector);
+    keyboardState.addListener(this);
   }
 
   ~KeyboardProcessor() override {
-    keyboardState.removeListener(&keyboardMessageCollector);
-  }
-
-  void prepareToPlay(double playbackSampleRate, int playbackSamplesPerBlock) override {
-    PlaybackProcessor::prepareToPlay(playbackSampleRate, playbackSamplesPerBlock);
-    keyboardMessageCollector.reset(playbackSampleRate);
-    hasCalledReset = true;
+    keyboardState.removeListener(this);
   }
 
   void
   on_data(Graph *graph, const std::optional<const Graph::Node::Pin> &pin, Data &data) override {
     juce::ignoreUnused(pin);
     auto input = std::any_cast<Block>(data);
-    juce::MidiBuffer output;
-    if (!input.midiBuffer.isEmpty()) {
-      output.addEvents(input.midiBuffer, 0, -1, 0);
-      keyboardState.processNextMidiBuffer(output, 0, output.getNumEvents(), true);
-    }
-    if (hasCalledReset) {
-      keyboardMessageCollector.removeNextBlockOfMessages(output, input.audioBuffer.getNumSamples());
-    }
-    Data result = std::make_any<Block>(input.audioBuffer, output);
+    injectKeyEvents(input);
+    sounding.update(input.events);
+    Data result = std::make_any<Block>(std::move(input));
     for (auto &[_, p]: m_outs) {
       p.async_dispatch(graph, result);
     }
@@ -66,4 +56,35 @@ struct KeyboardProcessor : public PlaybackProcessor {
   }
 
   juce::Component *createEditor(const GraphViewTheme &theme) override;
+
+protected:
+  // adds the keys pressed since the previous block, to the first of its blocks reaching the node
+  void injectKeyEvents(Block &block) {
+    if (!m_blocks.first(block)) return;
+    auto numSamples = block.audioBuffer.getNumSamples();
+    m_clock.begin();
+    keyEvents.pop([&](const KeyEvent &event) {
+      block.events.addEvent(event.bytes.data(), 3, m_clock.position(event.time, numSamples));
+    });
+  }
+
+private:
+  void handleNoteOn(juce::MidiKeyboardState *, int midiChannel, int midiNoteNumber, float velocity) override {
+    auto message = juce::MidiMessage::noteOn(midiChannel, midiNoteNumber, velocity);
+    pushKeyEvent(message);
+  }
+
+  void handleNoteOff(juce::MidiKeyboardState *, int midiChannel, int midiNoteNumber, float velocity) override {
+    auto message = juce::MidiMessage::noteOff(midiChannel, midiNoteNumber, velocity);
+    pushKeyEvent(message);
+  }
+
+  void pushKeyEvent(const juce::MidiMessage &message) {
+    KeyEvent event{BlockClock::now(), {}};
+    std::copy_n(message.getRawData(), 3, event.bytes.begin());
+    keyEvents.push(event);
+  }
+
+  OncePerBlock m_blocks;
+  BlockClock m_clock;
 };
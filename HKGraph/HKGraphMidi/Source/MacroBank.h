@@ -0,0 +1,134 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "Graph.h"
+#include "RangeParameter.h"
+
+// A fixed set of host parameters, each of which can be bound to one node parameter at a time.
+//
+// The host only ever sees the same Slots parameters, so binding, unbinding and rebuilding the graph
+// never change the plugin's parameter list. The audio thread finds the bound parameters through an
+// array of atomic pointers, and turns each block's movement of a macro into sample-positioned
+// changes on the node parameter (see IntRangeParameter::automate).
+struct MacroBank {
+  static constexpr int Slots = 16;
+
+  struct Binding {
+    uuid nodeId;
+    juce::String parameterId;
+  };
+
+  // creates the host parameters, call once from the AudioProcessor constructor
+  void addTo(juce::AudioProcessor &processor) {
+    for (auto i{0}; i < Slots; ++i) {
+      auto number = juce::String(i + 1);
+      auto parameter = new juce::AudioParameterFloat(juce::ParameterID{"macro-" + number, 1}, "Macro " + number, 0.0f, 1.0f, 0.0f);
+      m_parameters[static_cast<size_t>(i)] = parameter;
+      processor.addParameter(parameter);
+    }
+  }
+
+  // message thread, the macro jumps to the parameter's current value so binding does not move it
+  bool bind(int slot, Graph::Node *node, const juce::String &parameterId) {
+    auto automatable = dynamic_cast<AutomatableParameters *>(node);
+    auto target = automatable != nullptr ? automatable->automatableParameter(parameterId) : nullptr;
+    if (!isSlot(slot) || target == nullptr) return false;
+    auto i = static_cast<size_t>(slot);
+    m_parameters[i]->setValueNotifyingHost(target->toNormalised(target->get()));
+    m_bindings[i] = Binding{.nodeId = node->m_id, .parameterId = parameterId};
+    m_targets[i].store(target, std::memory_order_release);
+    return true;
+  }
+
+  // message thread
+  void unbind(int slot) {
+    if (!isSlot(slot)) return;
+    auto i = static_cast<size_t>(slot);
+    m_targets[i].store(nullptr, std::memory_order_release);
+    m_bindings[i].reset();
+  }
+
+  [[nodiscard]] const std::optional<Binding> &binding(int slot) const {
+    return m_bindings[static_cast<size_t>(slot)];
+  }
+
+  // called with the graph lock held, so the audio thread cannot be using a node that is gone
+  void prune(const Graph &graph) {
+    for (auto i{0}; i < Slots; ++i) {
+      auto const &b = m_bindings[static_cast<size_t>(i)];
+      if (b.has_value() && graph.m_nodes.find(b->nodeId) == std::end(graph.m_nodes)) {
+        unbind(i);
+      }
+    }
+  }
+
+  // audio thread, before the block is dispatched
+  void process(int numSamples, std::uint64_t block) {
+    for (size_t i = 0; i < static_cast<size_t>(Slots); ++i) {
+      auto target = m_targets[i].load(std::memory_order_acquire);
+      auto value = m_parameters[i]->get();
+      if (target != m_seen[i]) {
+        // a new binding starts from wherever the macro is now
+        m_seen[i] = target;
+        m_last[i] = value;
+        continue;
+      }
+      if (target == nullptr || value == m_last[i]) continue;
+      target->automate(m_last[i], value, numSamples, block);
+      m_last[i] = value;
+    }
+  }
+
+  void save(juce::ValueTree &macrosTree) const {
+    for (auto i{0}; i < Slots; ++i) {
+      juce::ValueTree macroTree{"macro"};
+      macroTree.setProperty("slot", juce::var(i), nullptr);
+      macroTree.setProperty("value", juce::var(m_parameters[static_cast<size_t>(i)]->get()), nullptr);
+      if (auto const &b = m_bindings[static_cast<size_t>(i)]; b.has_value()) {
+        macroTree.setProperty("node_id", juce::var(to_string(b->nodeId)), nullptr);
+        macroTree.setProperty("parameter", juce::var(b->parameterId), nullptr);
+      }
+      macrosTree.appendChild(macroTree, nullptr);
+    }
+  }
+
+  // message thread, after the graph was rebuilt
+  void restore(const juce::ValueTree &macrosTree, Graph &graph) {
+    for (auto i{0}; i < Slots; ++i) {
+      unbind(i);
+    }
+    for (auto const &macroTree: macrosTree) {
+      int slot = macroTree.getProperty("slot", -1);
+      if (!isSlot(slot)) continue;
+      *m_parameters[static_cast<size_t>(slot)] = static_cast<float>(macroTree.getProperty("value", 0.0f));
+      juce::String nodeId = macroTree.getProperty("node_id");
+      auto optNodeId = uuid::from_string(nodeId.toStdString());
+      if (optNodeId == std::nullopt) continue;
+      auto node = graph.m_nodes.find(optNodeId.value());
+      if (node != std::end(graph.m_nodes)) {
+        bind(slot, node->second, macroTree.getProperty("parameter").toString());
+      }
+    }
+  }
+
+  // message thread, before the nodes the bindings point to are deleted without the graph lock
+  void detach() {
+    for (auto &target: m_targets) {
+      target.store(nullptr, std::memory_order_release);
+    }
+  }
+
+private:
+  static bool isSlot(int slot) {
+    return slot >= 0 && slot < Slots;
+  }
+
+  // owned by the AudioProcessor
+  std::array<juce::AudioParameterFloat *, Slots> m_parameters{};
+  std::array<std::atomic<IntRangeParameter *>, Slots> m_targets{};
+  // message thread
+  std::array<std::optional<Binding>, Slots> m_bindings;
+  // audio thread
+  std::array<IntRangeParameter *, Slots> m_seen{};
+  std::array<float, Slots> m_last{};
+};
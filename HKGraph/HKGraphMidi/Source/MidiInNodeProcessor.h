@@ -14,6 +14,16 @@ struct MidiInNodeProcessor : public NodeProcessor {
 
   ~MidiInNodeProcessor() override = default;
 
+  // the block a host hands over, converted and decoded once for the rest of the graph, columns
+  // must stay untouched until the block is dispatched
+  static Data fromHost(const juce::AudioBuffer<float> &audioBuffer, const juce::MidiBuffer &midiBuffer,
+                       const Transport *transport, EventColumns &columns) {
+    Block block{audioBuffer, {}, transport};
+    block.events.addEvents(midiBuffer);
+    block.events.decodeShared(columns);
+    return std::make_any<Block>(std::move(block));
+  }
+
   void
   on_data(Graph *graph, const std::optional<const Node::Pin> &pin, Data &data) override {
     juce::ignoreUnused(pin);
@@ -3,7 +3,8 @@
 #include "NodeProcessor.h"
 
 struct MidiOutNodeProcessor : public NodeProcessor {
-  juce::MidiBuffer output;
+  // everything that reached this node during the current block
+  EventBuffer output;
 
   explicit MidiOutNodeProcessor(Graph *graph) :
     NodeProcessor(graph) {
@@ -17,8 +18,15 @@ struct MidiOutNodeProcessor : public NodeProcessor {
   void
   on_data(Graph *graph, const std::optional<const Node::Pin> &pin, Data &data) override {
     juce::ignoreUnused(graph, pin);
-    auto input = std::any_cast<Block>(data);
-    output.addEvents(input.midiBuffer, 0, -1, 0);
+    auto const &input = std::any_cast<const Block &>(data);
+    output.addEvents(input.events);
+  }
+
+  // replaces the host's buffer with this block's output and starts the next block
+  void toHost(juce::MidiBuffer &midiBuffer) {
+    midiBuffer.clear();
+    output.copyTo(midiBuffer);
+    output.clear();
   }
 
   [[nodiscard]] std::string typeId() const override {
@@ -3,23 +3,31 @@
 #include "Processors.h"
 #include "KeyboardProcessor.h"
 #include "ConstrainedComponent.h"
+#include "NoteMask.h"
 
 struct GraphKeyboardModel {
   int lastNotePressed{-1};
   bool showAllNoteNames{};
-  std::vector<int> disabledNoteNumbers;
+  // edited on the message thread, call publish() to hand a change to the audio thread
+  NoteMask disabledNotes;
+  AtomicNoteMask published;
   int enabledRangeBegin{1};
   int enabledRangeEnd{127};
+
+  void publish() {
+    published.publish(disabledNotes);
+  }
 };
 
-struct GraphKeyboardComponent : public juce::MidiKeyboardComponent {
+struct GraphKeyboardComponent : public MirroredKeyboardComponent {
   GraphKeyboardModel &model;
 
   GraphKeyboardComponent(
     juce::MidiKeyboardState &state,
+    const NoteMirror &noteMirror,
     juce::MidiKeyboardComponent::Orientation orientation,
     GraphKeyboardModel &graphKeyboardModel) :
-    juce::MidiKeyboardComponent(state, orientation),
+    MirroredKeyboardComponent(state, noteMirror, orientation),
     model(graphKeyboardModel) {}
 
   juce::String getWhiteNoteText(int midiNoteNumber) override {
@@ -31,9 +39,8 @@ struct GraphKeyboardComponent : public juce::MidiKeyboardComponent {
 
   void drawWhiteNote(int midiNoteNumber, juce::Graphics &g, juce::Rectangle<float> area, bool isDown, bool isOver,
                      juce::Colour lineColour, juce::Colour textColour) override {
-    MidiKeyboardComponent::drawWhiteNote(midiNoteNumber, g, area, isDown, isOver, lineColour, textColour);
-    auto p = std::find(model.disabledNoteNumbers.begin(), model.disabledNoteNumbers.end(), midiNoteNumber);
-    if (p != std::end(model.disabledNoteNumbers)) {
+    MirroredKeyboardComponent::drawWhiteNote(midiNoteNumber, g, area, isDown, isOver, lineColour, textColour);
+    if (!isEnabled(midiNoteNumber)) {
       g.setColour(juce::Colours::lightpink);
       g.fillRect(area);
       if (!lineColour.isTransparent()) {
@@ -73,9 +80,8 @@ struct GraphKeyboardComponent : public juce::MidiKeyboardComponent {
 
   void drawBlackNote(int midiNoteNumber, juce::Graphics &g, juce::Rectangle<float> area, bool isDown, bool isOver,
                      juce::Colour noteFillColour) override {
-    MidiKeyboardComponent::drawBlackNote(midiNoteNumber, g, area, isDown, isOver, noteFillColour);
-    auto p = std::find(model.disabledNoteNumbers.begin(), model.disabledNoteNumbers.end(), midiNoteNumber);
-    if (p != std::end(model.disabledNoteNumbers)) {
+    MirroredKeyboardComponent::drawBlackNote(midiNoteNumber, g, area, isDown, isOver, noteFillColour);
+    if (!isEnabled(midiNoteNumber)) {
       g.setColour(juce::Colours::red);
       g.fillRect(area);
     }
@@ -85,6 +91,7 @@ struct GraphKeyboardComponent : public juce::MidiKeyboardComponent {
     model.lastNotePressed = midiNoteNumber;
     if (e.mods.isAnyModifierKeyDown()) {
       toggleKey(midiNoteNumber);
+      model.publish();
     }
     return isEnabled(midiNoteNumber);
   }
@@ -98,6 +105,7 @@ struct GraphKeyboardComponent : public juce::MidiKeyboardComponent {
       for (auto candidate: range) {
         toggleKey(candidate);
       }
+      model.publish();
     }
     model.lastNotePressed = midiNoteNumber;
     return isEnabled(midiNoteNumber);
@@ -110,17 +118,11 @@ struct GraphKeyboardComponent : public juce::MidiKeyboardComponent {
 private:
 
   void toggleKey(int midiNoteNumber) {
-    auto p = std::find(std::begin(model.disabledNoteNumbers), std::end(model.disabledNoteNumbers), midiNoteNumber);
-    if (p != std::end(model.disabledNoteNumbers)) {
-      model.disabledNoteNumbers.erase(p);
-    } else {
-      model.disabledNoteNumbers.push_back(midiNoteNumber);
-    }
+    model.disabledNotes.toggle(midiNoteNumber);
   }
 
   bool isEnabled(int midiNoteNumber) {
-    auto p = std::find(std::begin(model.disabledNoteNumbers), std::end(model.disabledNoteNumbers), midiNoteNumber);
-    return p == std::end(model.disabledNoteNumbers);
+    return !model.disabledNotes.test(midiNoteNumber);
   }
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GraphKeyboardComponent)
@@ -144,26 +146,22 @@ struct NoteFilterProcessor : public KeyboardProcessor {
   on_data(Graph *graph, const std::optional<const Graph::Node::Pin> &pin, Data &data) override {
     juce::ignoreUnused(pin);
     auto input = std::any_cast<Block>(data);
-    juce::MidiBuffer output;
-    if (!input.midiBuffer.isEmpty()) {
-      for (auto const &n: input.midiBuffer) {
-        auto message = n.getMessage();
-        if (message.isNoteOnOrOff()) {
-          auto p = std::find(std::begin(model.disabledNoteNumbers), std::end(model.disabledNoteNumbers),
-                             message.getNoteNumber());
-          if (p == std::end(model.disabledNoteNumbers)) { // note NOT disabled
-            output.addEvent(message, n.samplePosition);
-          }
-        } else {
-          output.addEvent(message, n.samplePosition);
-        }
-      }
-      keyboardState.processNextMidiBuffer(output, 0, output.getNumEvents(), true);
-    }
-    if (hasCalledReset) {
-      keyboardMessageCollector.removeNextBlockOfMessages(output, input.audioBuffer.getNumSamples());
+    if (!input.events.isEmpty()) {
+      NoteMask::Bits disabled;
+      model.published.load(disabled);
+      input.events.rewrite([&](juce::uint8 *bytes, int size, int) {
+        // note on (0x9n) and note off (0x8n) are the only statuses with 100x in the top bits
+        auto status = bytes[0];
+        auto isNote = static_cast<std::uint64_t>((status & 0xE0) == 0x80);
+        auto note = size > 1 ? bytes[1] & 0x7F : 0;
+        auto word = static_cast<size_t>((status & 0x0F) * 2 + note / 64);
+        auto masked = (disabled[word] >> (note % 64)) & isNote;
+        return masked == 0;
+      });
     }
-    Data result = std::make_any<Block>(input.audioBuffer, output);
+    injectKeyEvents(input);
+    sounding.update(input.events);
+    Data result = std::make_any<Block>(std::move(input));
     for (auto &[_, p]: m_outs) {
       p.async_dispatch(graph, result);
     }
@@ -179,12 +177,22 @@ struct NoteFilterProcessor : public KeyboardProcessor {
     modelTree.setProperty("lastNotePressed", juce::var(model.lastNotePressed), nullptr);
     modelTree.setProperty("enabledRangeBegin", juce::var(model.enabledRangeBegin), nullptr);
     modelTree.setProperty("enabledRangeEnd", juce::var(model.enabledRangeEnd), nullptr);
+    // notes disabled on every channel, in the format older sessions used
     juce::Array<juce::var> disabledNoteNumbers;
-    disabledNoteNumbers.resize(static_cast<int>(model.disabledNoteNumbers.size()));
-    for (auto n: model.disabledNoteNumbers) {
-      disabledNoteNumbers.add(juce::var(n));
+    for (auto n{0}; n < NoteMask::Notes; ++n) {
+      if (model.disabledNotes.test(n)) {
+        disabledNoteNumbers.add(juce::var(n));
+      }
     }
     modelTree.setProperty("disabledNoteNumbers", juce::var(disabledNoteNumbers), nullptr);
+    // the full mask, only when channels differ, one little endian word after the other
+    if (!model.disabledNotes.isUniform()) {
+      juce::MemoryOutputStream mask;
+      for (auto word: model.disabledNotes.bits()) {
+        mask.writeInt64(static_cast<juce::int64>(word));
+      }
+      modelTree.setProperty("disabledNoteMask", juce::var(mask.getMemoryBlock()), nullptr);
+    }
 
     nodeTree.appendChild(modelTree, nullptr);
   }
@@ -195,12 +203,19 @@ struct NoteFilterProcessor : public KeyboardProcessor {
     model.lastNotePressed = modelTree.getProperty("lastNotePressed");
     model.enabledRangeBegin = modelTree.getProperty("enabledRangeBegin");
     model.enabledRangeEnd = modelTree.getProperty("enabledRangeEnd");
-    juce::Array<juce::var> *disabledNoteNumbers = modelTree.getProperty("disabledNoteNumbers").getArray();
-    model.disabledNoteNumbers.clear();
-    for (auto const &v: *disabledNoteNumbers) {
-      int n = v;
-      model.disabledNoteNumbers.push_back(n);
+    model.disabledNotes.clear();
+    if (auto *block = modelTree.getProperty("disabledNoteMask").getBinaryData();
+      block != nullptr && block->getSize() == sizeof(NoteMask::Bits)) {
+      juce::MemoryInputStream mask{*block, false};
+      for (auto &word: model.disabledNotes.bits()) {
+        word = static_cast<std::uint64_t>(mask.readInt64());
+      }
+    } else if (auto *disabledNoteNumbers = modelTree.getProperty("disabledNoteNumbers").getArray()) {
+      for (auto const &v: *disabledNoteNumbers) {
+        model.disabledNotes.set(static_cast<int>(v), true);
+      }
     }
+    model.publish();
   }
 
   NodeProcessor *clone() override {
@@ -210,7 +225,12 @@ struct NoteFilterProcessor : public KeyboardProcessor {
       static_cast<std::uint32_t>(m_ins.size()),
       static_cast<std::uint32_t>(m_outs.size()));
     c->m_muted = m_muted;
-    c->model = model;
+    c->model.lastNotePressed = model.lastNotePressed;
+    c->model.showAllNoteNames = model.showAllNoteNames;
+    c->model.disabledNotes = model.disabledNotes;
+    c->model.enabledRangeBegin = model.enabledRangeBegin;
+    c->model.enabledRangeEnd = model.enabledRangeEnd;
+    c->model.publish();
     return c;
   }
 
@@ -227,6 +247,7 @@ struct NoteFilterProcessor : public KeyboardProcessor {
         theme(viewTheme),
         keyboardComponent(
           p->keyboardState,
+          p->sounding,
           juce::MidiKeyboardComponent::Orientation::horizontalKeyboard,
           p->model),
         sliderBeginNoteRange(juce::Slider::LinearBar, juce::Slider::TextBoxLeft),
@@ -324,15 +345,11 @@ struct NoteFilterProcessor : public KeyboardProcessor {
     }
 
     void sliderValueChanged(juce::Slider *) override {
-      processor->model.disabledNoteNumbers.clear();
-      processor->model.enabledRangeBegin = static_cast<int>(sliderBeginNoteRange.getValue());
-      for (auto i{0}; i < processor->model.enabledRangeBegin; ++i) {
-        processor->model.disabledNoteNumbers.push_back(i);
-      }
-      processor->model.enabledRangeEnd = static_cast<int>(sliderEndNoteRange.getValue());
-      for (auto i{processor->model.enabledRangeEnd + 1}; i <= 127; ++i) {
-        processor->model.disabledNoteNumbers.push_back(i);
-      }
+      auto &model = processor->model;
+      model.enabledRangeBegin = static_cast<int>(sliderBeginNoteRange.getValue());
+      model.enabledRangeEnd = static_cast<int>(sliderEndNoteRange.getValue());
+      model.disabledNotes.setOutside(model.enabledRangeBegin, model.enabledRangeEnd);
+      model.publish();
       keyboardComponent.repaint();
     }
 
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+// One bit per (channel, note) pair: 16 channels x 128 notes in 32 words, laid out like
+// ActiveNoteTracker. Plain value type, edited on the message thread.
+struct NoteMask {
+  static constexpr int Channels = 16;
+  static constexpr int Notes = 128;
+  static constexpr size_t Words = Channels * Notes / 64;
+
+  using Bits = std::array<std::uint64_t, Words>;
+
+  // channel is 1-based like juce::MidiMessage, out of range pairs are ignored
+  void set(int channel, int note, bool value) {
+    if (!inRange(channel, note)) return;
+    if (value) {
+      m_bits[word(channel, note)] |= bit(note);
+    } else {
+      m_bits[word(channel, note)] &= ~bit(note);
+    }
+  }
+
+  [[nodiscard]] bool test(int channel, int note) const {
+    return inRange(channel, note) && (m_bits[word(channel, note)] & bit(note)) != 0;
+  }
+
+  // the same note on every channel
+  void set(int note, bool value) {
+    for (auto channel{1}; channel <= Channels; ++channel) {
+      set(channel, note, value);
+    }
+  }
+
+  void toggle(int note) {
+    set(note, !test(note));
+  }
+
+  // true if the note is set on every channel
+  [[nodiscard]] bool test(int note) const {
+    if (note < 0 || note >= Notes) return false;
+    auto all = ~std::uint64_t{0};
+    for (auto channel{1}; channel <= Channels; ++channel) {
+      all &= m_bits[word(channel, note)];
+    }
+    return (all & bit(note)) != 0;
+  }
+
+  // sets every note outside [begin, end] on every channel and clears the rest
+  void setOutside(int begin, int end) {
+    std::array<std::uint64_t, 2> inside{};
+    for (auto note{std::max(begin, 0)}; note <= std::min(end, Notes - 1); ++note) {
+      inside[static_cast<size_t>(note / 64)] |= bit(note);
+    }
+    for (size_t i = 0; i < Words; ++i) {
+      m_bits[i] = ~inside[i % 2];
+    }
+  }
+
+  void clear() {
+    m_bits.fill(0);
+  }
+
+  // true if every channel carries the same notes
+  [[nodiscard]] bool isUniform() const {
+    for (size_t i = 2; i < Words; ++i) {
+      if (m_bits[i] != m_bits[i % 2]) return false;
+    }
+    return true;
+  }
+
+  [[nodiscard]] const Bits &bits() const {
+    return m_bits;
+  }
+
+  Bits &bits() {
+    return m_bits;
+  }
+
+  static size_t word(int channel, int note) {
+    return static_cast<size_t>((channel - 1) * 2 + note / 64);
+  }
+
+  static std::uint64_t bit(int note) {
+    return std::uint64_t{1} << (note % 64);
+  }
+
+private:
+  static bool inRange(int channel, int note) {
+    return channel >= 1 && channel <= Channels && note >= 0 && note < Notes;
+  }
+
+  Bits m_bits{};
+};
+
+// A NoteMask shared with the audio thread. The message thread publishes a whole mask, the audio
+// thread copies it once per block and tests events against the copy, so filtering never locks.
+// A block that races a publish may see some words old and some new, which only delays part of
+// an edit by one block.
+struct AtomicNoteMask {
+  void publish(const NoteMask &mask) {
+    auto const &bits = mask.bits();
+    for (size_t i = 0; i < NoteMask::Words; ++i) {
+      m_bits[i].store(bits[i], std::memory_order_relaxed);
+    }
+  }
+
+  void load(NoteMask::Bits &bits) const {
+    for (size_t i = 0; i < NoteMask::Words; ++i) {
+      bits[i] = m_bits[i].load(std::memory_order_relaxed);
+    }
+  }
+
+private:
+  std::array<std::atomic<std::uint64_t>, NoteMask::Words> m_bits{};
+};
@@ -9,8 +9,26 @@ AudioPluginAudioProcessorEditor::AudioPluginAudioProcessorEditor(AudioPluginAudi
   graphEditor->restoreUI(p.nodeDescriptors);
   ///
   graphEditor->setSize(p.preferences.editorWidth, p.preferences.editorHeight);
+  graphEditor->isCapturing = [this]() { return processorRef.isCapturing(); };
+  graphEditor->toggleCapture = [this]() {
+    if (processorRef.isCapturing()) {
+      processorRef.stopCapture();
+    } else {
+      auto directory = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("HKGraphMidi");
+      directory.createDirectory();
+      processorRef.startCapture(directory.getNonexistentChildFile("capture", ".hkcap"));
+    }
+  };
+
+  graphEditor->macros = &p.macros;
+
+  graphEditor->resetTelemetry = [this]() {
+    processorRef.resetTelemetry();
+    telemetryOverlay.setSnapshot(processorRef.telemetrySnapshot());
+  };
 
   addAndMakeVisible(graphEditor.get());
+  addAndMakeVisible(telemetryOverlay);
 
   setSize(p.preferences.editorWidth, p.preferences.editorHeight);
   setResizable(true, true);
@@ -31,8 +49,14 @@ void AudioPluginAudioProcessorEditor::recordUI() {
   graphEditor->recordUI(processorRef.nodeDescriptors);
 }
 
+void AudioPluginAudioProcessorEditor::updateTelemetry(const BlockTelemetry::Snapshot &snapshot) {
+  telemetryOverlay.setSnapshot(snapshot);
+}
+
 void AudioPluginAudioProcessorEditor::resized() {
   graphEditor->setBounds(getLocalBounds());
+  telemetryOverlay.setBounds(
+    getWidth() - TelemetryOverlay::WIDTH - 20, 8, TelemetryOverlay::WIDTH, TelemetryOverlay::HEIGHT);
   processorRef.preferences.editorWidth = graphEditor->getWidth();
   processorRef.preferences.editorHeight = graphEditor->getHeight();
 }
@@ -2,6 +2,7 @@
 
 #include "PluginProcessor.h"
 #include "GraphEditor.h"
+#include "TelemetryOverlay.h"
 
 class AudioPluginAudioProcessorEditor final : public juce::AudioProcessorEditor {
 public:
@@ -15,11 +16,14 @@ public:
 
   void recordUI();
 
+  void updateTelemetry(const BlockTelemetry::Snapshot &snapshot);
+
 private:
 
   AudioPluginAudioProcessor &processorRef;
   juce::TooltipWindow tooltipWindow;
   std::unique_ptr<GraphEditor> graphEditor;
+  TelemetryOverlay telemetryOverlay;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioPluginAudioProcessorEditor)
 };
@@ -6,30 +6,115 @@ AudioPluginAudioProcessor::AudioPluginAudioProcessor()
                      .withInput("Input", juce::AudioChannelSet::stereo(), true)
                      .withOutput("Output", juce::AudioChannelSet::stereo(), true)),
     graph(new Graph()), parameters("parameters-1.0.0") {
+  macros.addTo(*this);
   midiIn = new MidiInNodeProcessor(graph, "midi-in", 0, 1);
   midiOut = new MidiOutNodeProcessor(graph, "midi-out", 1, 0);
   graph->add_node(midiIn);
   graph->add_node(midiOut);
   assignMidiInOutDescriptors();
   graph->add_listener(this);
+  graph->m_data_listener = this;
+  syncNoteTracking();
   startTimer(1 * 1000);
 }
 
 AudioPluginAudioProcessor::~AudioPluginAudioProcessor() {
   stopTimer();
+  capture.stop();
   graph->remove_listener(this);
   delete graph;
 }
 
 void AudioPluginAudioProcessor::on_graph_event(const Graph::Event &event) {
-  if (
-    event == Graph::Event::NodeRemoved ||
-    event == Graph::Event::NodeMuted ||
-    event == Graph::Event::EdgeRemoved) {
-    m_dirty = true;
+  if (event == Graph::Event::NodeMuted) {
+    // muting does not take the graph lock, the audio thread picks it up on the next block
+    muteChanged = true;
+  } else if (!restoring) {
+    syncNoteTracking();
+    if (event == Graph::Event::NodeRemoved) {
+      macros.prune(*graph);
+    }
+  }
+  // topology changes hold the graph lock, the block waiting for it is the first one to see the change
+  if (capture.isActive() && !restoring) {
+    capture.writeTopology(blockCounter.load(), static_cast<int>(event), captureState());
   }
 }
 
+void AudioPluginAudioProcessor::on_edge_data(const Graph::Edge &edge, const Data &data) {
+  auto itr = edgeNotes.find(edge.m_id);
+  if (itr != std::end(edgeNotes)) {
+    if (auto block = std::any_cast<Block>(&data)) {
+      itr->second.sounding.process(block->events);
+    }
+  }
+}
+
+// called with the graph lock held: notes sounding on an edge that is gone are owed to its target pin
+void AudioPluginAudioProcessor::syncNoteTracking() {
+  for (auto itr = std::begin(edgeNotes); itr != std::end(edgeNotes);) {
+    if (graph->m_edges.find(itr->first) == std::end(graph->m_edges)) {
+      auto pending = pendingNoteOffs.find(itr->second.targetPinId);
+      if (pending != std::end(pendingNoteOffs) && itr->second.sounding.any()) {
+        pending->second.merge(itr->second.sounding);
+        notesPending = true;
+      }
+      itr = edgeNotes.erase(itr);
+    } else {
+      ++itr;
+    }
+  }
+  for (auto const &[id, edge]: graph->m_edges) {
+    if (edgeNotes.find(id) == std::end(edgeNotes)) {
+      edgeNotes[id] = EdgeNotes{.targetPinId = edge.m_target_pin_id, .sounding = {}};
+    }
+  }
+  // allocate the pending slots here, so the audio thread never inserts
+  std::erase_if(pendingNoteOffs, [&](auto const &p) {
+    return graph->m_pins.find(p.first) == std::end(graph->m_pins);
+  });
+  for (auto const &[id, pin]: graph->m_pins) {
+    if (pin.m_kind == Graph::Node::PinKind::In && pendingNoteOffs.find(id) == std::end(pendingNoteOffs)) {
+      pendingNoteOffs[id] = ActiveNoteTracker{};
+    }
+  }
+}
+
+// a muted node stops forwarding, so whatever it started downstream has to be released
+void AudioPluginAudioProcessor::releaseMutedPaths() {
+  for (auto &[id, notes]: edgeNotes) {
+    if (!notes.sounding.any()) continue;
+    auto edge = graph->m_edges.find(id);
+    if (edge == std::end(graph->m_edges)) continue;
+    auto source = graph->m_nodes.find(edge->second.m_source_node_id);
+    if (source != std::end(graph->m_nodes) && source->second->is_muted()) {
+      auto pending = pendingNoteOffs.find(notes.targetPinId);
+      if (pending != std::end(pendingNoteOffs)) {
+        pending->second.merge(notes.sounding);
+        notesPending = true;
+      }
+      notes.sounding.clear();
+    }
+  }
+}
+
+void AudioPluginAudioProcessor::flushPendingNoteOffs(const juce::AudioBuffer<float> &buffer) {
+  for (auto &[pinId, notes]: pendingNoteOffs) {
+    if (!notes.any()) continue;
+    noteOffs.clear();
+    notes.releaseAll(noteOffs, 0);
+    auto pin = graph->m_pins.find(pinId);
+    if (pin != std::end(graph->m_pins)) {
+      // the note-offs travel the rest of the path, so downstream nodes transform them like any other event.
+      // They belong to the host block about to be dispatched: a node they reach begins that block here,
+      // and does not begin it again when the host's events arrive.
+      Data data = std::make_any<Block>(buffer, noteOffs, &transport);
+      pin->second.async_dispatch(graph, data);
+    }
+  }
+  notesPending = false;
+}
+
 const juce::String AudioPluginAudioProcessor::getName() const {
   return "HKGraphMidi";
 }
@@ -113,23 +198,38 @@ bool AudioPluginAudioProcessor::isBusesLayoutSupported(const BusesLayout &layout
 
 void AudioPluginAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer,
                                              juce::MidiBuffer &midiMessages) {
+  // waiting for the lock counts, it eats into the same deadline
+  auto start = std::chrono::steady_clock::now();
   std::lock_guard<std::mutex> lock(graph->m_mutex);
+  capture.writeBlock(blockCounter.load(), getSampleRate(), buffer.getNumSamples(), midiMessages);
   // https://forum.juce.com/t/processblock-sampleposition-gettimestamp-interpretation/56172/3
-  if (m_dirty) {
-    juce::MidiBuffer output;
-    for (auto i = 1; i <= 16; i++) {
-      output.addEvent(juce::MidiMessage::allNotesOff(i), 0);
+  if (muteChanged.exchange(false)) {
+    releaseMutedPaths();
+  }
+  transport.block = blockCounter.load();
+  transport.sampleRate = getSampleRate();
+  transport.position = {};
+  if (auto *playHead = getPlayHead()) {
+    if (auto position = playHead->getPosition()) {
+      transport.position = *position;
     }
-    midiMessages.swapWith(output);
-    m_dirty = false;
-    midiOut->output.clear();
-  } else {
-    Data input = std::make_any<Block>(buffer, midiMessages);
-    midiIn->async_dispatch(graph, std::nullopt, input);
-    midiMessages.swapWith(midiOut->output);
-    midiOut->output.clear();
   }
+  // ahead of anything dispatched in this block, the flush included
+  macros.process(buffer.getNumSamples(), transport.block);
+  if (notesPending) {
+    flushPendingNoteOffs(buffer);
+  }
+  Data input = MidiInNodeProcessor::fromHost(buffer, midiMessages, &transport, hostColumns);
+  midiIn->async_dispatch(graph, std::nullopt, input);
+  midiOut->toHost(midiMessages);
   buffer.clear();
+  ++blockCounter;
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  auto deadline = getSampleRate() > 0.0
+                  ? static_cast<std::uint64_t>(buffer.getNumSamples() * 1.0e9 / getSampleRate())
+                  : 0;
+  telemetry.record(static_cast<std::uint64_t>(elapsed.count()), deadline);
 }
 
 bool AudioPluginAudioProcessor::hasEditor() const {
@@ -141,13 +241,17 @@ juce::AudioProcessorEditor *AudioPluginAudioProcessor::createEditor() {
 }
 
 void AudioPluginAudioProcessor::saveState() {
-  parameters.removeAllChildren(nullptr);
-  parameters.removeAllProperties(nullptr);
+  saveState(parameters);
+}
+
+void AudioPluginAudioProcessor::saveState(juce::ValueTree &state) {
+  state.removeAllChildren(nullptr);
+  state.removeAllProperties(nullptr);
 
   juce::ValueTree ui{"ui"};
   ui.setProperty("preferences-editor-width", juce::var(preferences.editorWidth), nullptr);
   ui.setProperty("preferences-editor-height", juce::var(preferences.editorHeight), nullptr);
-  parameters.appendChild(ui, nullptr);
+  state.appendChild(ui, nullptr);
 
   juce::ValueTree graphTree{"graph"};
   graphTree.setProperty("async", graph->async, nullptr);
@@ -216,10 +320,17 @@ void AudioPluginAudioProcessor::saveState() {
   }
   graphTree.appendChild(descriptorsTree, nullptr);
 
-  parameters.appendChild(graphTree, nullptr);
+  state.appendChild(graphTree, nullptr);
+
+  juce::ValueTree macrosTree{"macros"};
+  macros.save(macrosTree);
+  state.appendChild(macrosTree, nullptr);
 }
 
 void AudioPluginAudioProcessor::restoreState() {
+  // rebuilding the graph fires an event per node, those are not individual topology changes
+  const juce::ScopedValueSetter<bool> restoringState(restoring, true);
+  macros.detach();
   nodeDescriptors.clear();
   graph->m_edges.clear();
   graph->m_pins.clear();
@@ -364,6 +475,13 @@ void AudioPluginAudioProcessor::restoreState() {
   }
 
   recoverMidiInOut();
+  macros.restore(parameters.getChildWithName("macros"), *graph);
+
+  // whatever was sounding belonged to the previous graph
+  edgeNotes.clear();
+  pendingNoteOffs.clear();
+  notesPending = false;
+  syncNoteTracking();
 }
 
 void AudioPluginAudioProcessor::recoverMidiInOut() {
@@ -441,11 +559,56 @@ void AudioPluginAudioProcessor::setStateInformation(const void *data, int sizeIn
   juce::MemoryInputStream in{data, static_cast<size_t>(sizeInBytes), false};
   parameters = juce::ValueTree::readFromStream(in);
   restoreState();
+  if (capture.isActive()) {
+    capture.writeTopology(blockCounter.load(), BlockCapture::fullState, captureState());
+  }
 }
 
 void AudioPluginAudioProcessor::timerCallback() {
   if (auto *editor = dynamic_cast<AudioPluginAudioProcessorEditor *>(getActiveEditor())) {
     editor->recordUI();
+    editor->updateTelemetry(telemetrySnapshot());
+  }
+}
+
+bool AudioPluginAudioProcessor::startCapture(const juce::File &file) {
+  return capture.start(file, blockCounter.load(), captureState());
+}
+
+void AudioPluginAudioProcessor::stopCapture() {
+  capture.stop();
+}
+
+bool AudioPluginAudioProcessor::isCapturing() const {
+  return capture.isActive();
+}
+
+juce::MemoryBlock AudioPluginAudioProcessor::captureState() {
+  juce::ValueTree state{parameters.getType()};
+  saveState(state);
+  juce::MemoryBlock block;
+  juce::MemoryOutputStream out{block, false};
+  state.writeToStream(out);
+  return block;
+}
+
+BlockTelemetry::Snapshot AudioPluginAudioProcessor::telemetrySnapshot() const {
+  auto snapshot = telemetry.snapshot();
+  // nodes are only added and removed on the message thread, the timer runs there as well
+  for (auto const &[_, node]: graph->m_nodes) {
+    auto p99 = static_cast<double>(node->m_time.percentile(0.99)) / 1000.0;
+    if (node->m_time.count() > 0 && p99 >= snapshot.slowestNodeP99) {
+      snapshot.slowestNode = node->m_name;
+      snapshot.slowestNodeP99 = p99;
+    }
+  }
+  return snapshot;
+}
+
+void AudioPluginAudioProcessor::resetTelemetry() {
+  telemetry.reset();
+  for (auto const &[_, node]: graph->m_nodes) {
+    node->m_time.reset();
   }
 }
 
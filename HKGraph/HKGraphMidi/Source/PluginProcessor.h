@@ -6,22 +6,33 @@
 #include "MidiOutNodeProcessor.h"
 #include "NodeDescriptor.h"
 #include "ProcessorRegistry.h"
+#include "BlockCapture.h"
+#include "BlockTelemetry.h"
+#include "ActiveNoteTracker.h"
+#include "MacroBank.h"
 
 struct Preferences {
   int editorWidth = 800;
   int editorHeight = 400;
 };
 
-class AudioPluginAudioProcessor final : public juce::AudioProcessor, private juce::Timer, private Graph::Listener {
+class AudioPluginAudioProcessor final
+  : public juce::AudioProcessor, private juce::Timer, private Graph::Listener, private Graph::DataListener {
 
 public:
   Graph *graph;
   std::unordered_map<uuid, std::unique_ptr<NodeDescriptor>> nodeDescriptors;
   MidiInNodeProcessor *midiIn;
   MidiOutNodeProcessor *midiOut;
-  bool m_dirty{false};
   Preferences preferences;
   juce::ValueTree parameters;
+  BlockCapture capture;
+  std::atomic<std::uint64_t> blockCounter{0};
+  BlockTelemetry telemetry;
+  MacroBank macros;
+  // audio thread
+  Transport transport;
+  EventColumns hostColumns;
 
   AudioPluginAudioProcessor();
 
@@ -29,6 +40,8 @@ public:
 
   void on_graph_event(const Graph::Event &event) override;
 
+  void on_edge_data(const Graph::Edge &edge, const Data &data) override;
+
   void prepareToPlay(double sampleRate, int samplesPerBlock) override;
 
   void releaseResources() override;
@@ -65,6 +78,8 @@ public:
 
   void saveState();
 
+  void saveState(juce::ValueTree &state);
+
   void restoreState();
 
   void recoverMidiInOut();
@@ -77,6 +92,39 @@ public:
 
   void timerCallback() override;
 
+  bool startCapture(const juce::File &file);
+
+  void stopCapture();
+
+  [[nodiscard]] bool isCapturing() const;
+
+  juce::MemoryBlock captureState();
+
+  [[nodiscard]] BlockTelemetry::Snapshot telemetrySnapshot() const;
+
+  void resetTelemetry();
+
 private:
+  struct EdgeNotes {
+    uuid targetPinId;
+    ActiveNoteTracker sounding;
+  };
+
+  void syncNoteTracking();
+
+  void releaseMutedPaths();
+
+  void flushPendingNoteOffs(const juce::AudioBuffer<float> &buffer);
+
+  bool restoring{false};
+  // notes that went through each edge and have not been released yet
+  std::unordered_map<uuid, EdgeNotes> edgeNotes;
+  // note-offs owed to each in pin, sent at the start of the next block
+  std::unordered_map<uuid, ActiveNoteTracker> pendingNoteOffs;
+  bool notesPending{false};
+  // audio thread, reused by every flush so sending note-offs does not allocate
+  EventBuffer noteOffs;
+  std::atomic<bool> muteChanged{false};
+
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioPluginAudioProcessor)
 };
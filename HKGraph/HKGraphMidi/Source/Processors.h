@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include "JuceHeader.h"
+#include "EventBuffer.h"
 
 struct Processors {
   static const std::string midiInNodeProcessor;
@@ -17,7 +18,37 @@ struct Processors {
   static const std::string pianoRollProcessor;
 };
 
+// Where the host's transport is for the block being processed, filled in once per host block.
+struct Transport {
+  // counts host blocks, a node reached twice in one block sees the same value
+  std::uint64_t block{0};
+  double sampleRate{0.0};
+  juce::AudioPlayHead::PositionInfo position;
+};
+
 struct Block {
   juce::AudioBuffer<float> audioBuffer;
-  juce::MidiBuffer midiBuffer;
+  EventBuffer events;
+  // valid while the block is being dispatched, null for blocks that do not come from the host
+  const Transport *transport{nullptr};
+
+  static constexpr std::uint64_t NoHostBlock = ~std::uint64_t{0};
+
+  [[nodiscard]] std::uint64_t hostBlock() const {
+    return transport != nullptr ? transport->block : NoHostBlock;
+  }
+};
+
+// Tells a node whether it is seeing a host block for the first time. A node reached by several
+// paths gets on_data more than once per block. Blocks without a transport always count as new.
+struct OncePerBlock {
+  bool first(const Block &block) {
+    if (block.transport == nullptr) return true;
+    if (block.transport->block == m_last) return false;
+    m_last = block.transport->block;
+    return true;
+  }
+
+private:
+  std::uint64_t m_last{~std::uint64_t{0}};
 };
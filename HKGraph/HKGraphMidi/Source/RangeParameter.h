@@ -1,6 +1,194 @@
 #pragma once
 
+#include "JuceHeader.h"
+#include "BlockClock.h"
+
+// An integer parameter edited on the message thread and read on the audio thread.
+//
+// set() stores the value atomically and queues a timestamped change on a wait-free queue. Once
+// per block the audio thread calls beginBlock(), which turns the queued changes into sample
+// positions, and then asks valueAt() for the value in effect at each event, so a change lands on
+// the sample it was made at (one block late) instead of at a block boundary.
+//
+// Host automation arrives on the audio thread through automate(), ahead of the block it belongs
+// to, and is merged with the queued changes by beginBlock() for that same block. A node that does
+// not begin every block (muted, not wired) does not replay old ramps later: ramps from an earlier
+// block are dropped and only the value they ended on is kept.
 struct IntRangeParameter {
-  int min{}, max{}, step{}, value{};
-  bool changed{false};
-};
\ No newline at end of file
+  static constexpr int MaxChanges = 64;
+  static constexpr int MaxAutomation = 128;
+
+  const int min, max, step;
+
+  IntRangeParameter(int minimum, int maximum, int stepSize, int initial)
+    : min(minimum), max(maximum), step(stepSize) {
+    reset(initial);
+  }
+
+  // message thread, a change that does not fit in the queue (a node that is muted or not wired
+  // does not drain it) is not lost: the next beginBlock ends on the latest value
+  void set(int newValue) {
+    newValue = juce::jlimit(min, max, newValue);
+    m_value.store(newValue, std::memory_order_relaxed);
+    auto scope = m_fifo.write(1);
+    if (scope.blockSize1 > 0) {
+      m_queue[static_cast<size_t>(scope.startIndex1)] = {BlockClock::now(), newValue};
+    } else {
+      m_overflowed.store(true, std::memory_order_release);
+    }
+  }
+
+  // the latest value, from any thread
+  [[nodiscard]] int get() const {
+    return m_value.load(std::memory_order_relaxed);
+  }
+
+  // sets the value at once, for nodes that are not playing yet (restore, clone)
+  void reset(int newValue) {
+    newValue = juce::jlimit(min, max, newValue);
+    m_value.store(newValue, std::memory_order_relaxed);
+    m_current = newValue;
+    m_numChanges = 0;
+    m_numAutomated = 0;
+    m_cursor = 0;
+    m_overflowed = false;
+  }
+
+  [[nodiscard]] float toNormalised(int v) const {
+    return max > min ? static_cast<float>(v - min) / static_cast<float>(max - min) : 0.0f;
+  }
+
+  [[nodiscard]] int fromNormalised(float normalised) const {
+    auto steps = juce::roundToInt(juce::jlimit(0.0f, 1.0f, normalised) * static_cast<float>(max - min) / static_cast<float>(step));
+    return juce::jlimit(min, max, min + steps * step);
+  }
+
+  // audio thread, before the block is dispatched: a host parameter moved from one normalised value
+  // to another over the coming block. The ramp between the two is turned into a change at every
+  // sample where the integer value steps, so automation sweeps instead of jumping once per block.
+  void automate(float from, float to, int numSamples, std::uint64_t block) {
+    auto first = fromNormalised(from);
+    auto last = fromNormalised(to);
+    m_value.store(last, std::memory_order_relaxed);
+    if (block != m_automatedBlock) {
+      m_numAutomated = 0;
+      m_automatedBlock = block;
+    }
+    if (first == last) {
+      addAutomated(0, last);
+      return;
+    }
+    // the ramp starts at from, whatever the value was before
+    addAutomated(0, first);
+    auto direction = last > first ? step : -step;
+    for (auto v = first + direction; ; v += direction) {
+      // the ramp reaches v where it crosses the midpoint between v and the previous step
+      auto boundary = (static_cast<float>(v - min) - static_cast<float>(direction) / 2.0f) / static_cast<float>(max - min);
+      auto position = static_cast<int>(std::ceil((boundary - from) / (to - from) * static_cast<float>(numSamples)));
+      addAutomated(juce::jlimit(0, std::max(0, numSamples - 1), position), v);
+      if (v == last) break;
+    }
+  }
+
+  // audio thread, once per host block: calling it again within a block restarts the clock and
+  // applies every pending change at once (see OncePerBlock)
+  void beginBlock(int numSamples, std::uint64_t block) {
+    m_clock.begin();
+    // whatever was left of the previous block is in effect now
+    while (m_cursor < m_numChanges) {
+      m_current = m_changes[static_cast<size_t>(m_cursor++)].value;
+    }
+    m_numChanges = 0;
+    m_cursor = 0;
+    auto scope = m_fifo.read(m_fifo.getNumReady());
+    auto add = [&](const Queued &queued) {
+      m_changes[static_cast<size_t>(m_numChanges++)] = {m_clock.position(queued.time, numSamples), queued.value};
+    };
+    for (auto i{0}; i < scope.blockSize1; ++i) add(m_queue[static_cast<size_t>(scope.startIndex1 + i)]);
+    for (auto i{0}; i < scope.blockSize2; ++i) add(m_queue[static_cast<size_t>(scope.startIndex2 + i)]);
+    if (m_overflowed.exchange(false, std::memory_order_acquire)) {
+      // changes were dropped, the latest value wins from the last queued change on
+      auto position = m_numChanges > 0 ? m_changes[static_cast<size_t>(m_numChanges - 1)].position : 0;
+      m_changes[static_cast<size_t>(m_numChanges++)] = {position, get()};
+    }
+    if (m_numAutomated > 0 && m_automatedBlock != block) {
+      // ramps of a block this parameter never began, it starts on where the last one ended
+      m_automated[0] = {0, m_automated[static_cast<size_t>(m_numAutomated - 1)].value};
+      m_numAutomated = 1;
+    }
+    // both lists are sorted by position, automation goes after a queued change at the same sample
+    for (auto i{0}; i < m_numAutomated; ++i) {
+      auto change = m_automated[static_cast<size_t>(i)];
+      auto at = m_numChanges;
+      while (at > 0 && m_changes[static_cast<size_t>(at - 1)].position > change.position) {
+        m_changes[static_cast<size_t>(at)] = m_changes[static_cast<size_t>(at - 1)];
+        --at;
+      }
+      m_changes[static_cast<size_t>(at)] = change;
+      ++m_numChanges;
+    }
+    m_numAutomated = 0;
+  }
+
+  // audio thread, positions must not go backwards within a block
+  int valueAt(int samplePosition) {
+    while (m_cursor < m_numChanges && m_changes[static_cast<size_t>(m_cursor)].position <= samplePosition) {
+      m_current = m_changes[static_cast<size_t>(m_cursor++)].value;
+    }
+    return m_current;
+  }
+
+private:
+  struct Queued {
+    double time;
+    int value;
+  };
+
+  struct Change {
+    int position;
+    int value;
+  };
+
+  // keeps the last change if a sweep steps more often than there is room for
+  void addAutomated(int position, int v) {
+    if (m_numAutomated == MaxAutomation) --m_numAutomated;
+    m_automated[static_cast<size_t>(m_numAutomated++)] = {position, v};
+  }
+
+  std::atomic<int> m_value{0};
+  std::atomic<bool> m_overflowed{false};
+  juce::AbstractFifo m_fifo{MaxChanges};
+  std::array<Queued, MaxChanges> m_queue{};
+
+  // audio thread
+  BlockClock m_clock;
+  std::array<Change, MaxChanges + MaxAutomation> m_changes{};
+  int m_numChanges{0};
+  std::array<Change, MaxAutomation> m_automated{};
+  int m_numAutomated{0};
+  std::uint64_t m_automatedBlock{0};
+  int m_cursor{0};
+  int m_current{0};
+
+  JUCE_DECLARE_NON_COPYABLE(IntRangeParameter)
+};
+
+// Implemented by nodes whose parameters can be bound to host macros (see MacroBank). Ids are
+// persisted with the binding, so they must not change between versions.
+struct AutomatableParameters {
+  struct Entry {
+    juce::String id;
+    IntRangeParameter *parameter;
+  };
+
+  virtual ~AutomatableParameters() = default;
+
+  virtual std::vector<Entry> automatableParameters() = 0;
+
+  IntRangeParameter *automatableParameter(const juce::String &id) {
+    for (auto const &entry: automatableParameters()) {
+      if (entry.id == id) return entry.parameter;
+    }
+    return nullptr;
+  }
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+// Tests on raw message bytes, for per-event transforms that edit an EventBuffer in place
+// (see EventBuffer::rewrite) instead of building a juce::MidiMessage per event.
+struct RawMidi {
+  static bool isNoteOn(const juce::uint8 *bytes, int size) {
+    return size == 3 && (bytes[0] & 0xF0) == 0x90 && bytes[2] != 0;
+  }
+
+  // includes note-on with velocity 0
+  static bool isNoteOff(const juce::uint8 *bytes, int size) {
+    return size == 3 && ((bytes[0] & 0xF0) == 0x80 || ((bytes[0] & 0xF0) == 0x90 && bytes[2] == 0));
+  }
+
+  static bool isChannelMessage(const juce::uint8 *bytes, int size) {
+    return size > 0 && bytes[0] >= 0x80 && bytes[0] < 0xF0;
+  }
+};
+
+// Remembers one byte per (channel, note) of a note-on, so the matching note-off can be rewritten
+// the same way even if the processor's parameters changed in between. Channels are 0-based here,
+// as they appear in the status byte.
+struct NoteMap {
+  static constexpr std::int8_t Unknown = -1;
+  // the note-on was dropped, so is its note-off
+  static constexpr std::int8_t Dropped = -2;
+
+  NoteMap() {
+    clear();
+  }
+
+  void clear() {
+    m_values.fill(Unknown);
+  }
+
+  void set(int channel, int note, std::int8_t value) {
+    m_values[index(channel, note)] = value;
+  }
+
+  [[nodiscard]] std::int8_t get(int channel, int note) const {
+    return m_values[index(channel, note)];
+  }
+
+  // returns the value and forgets it
+  std::int8_t take(int channel, int note) {
+    auto &slot = m_values[index(channel, note)];
+    auto value = slot;
+    slot = Unknown;
+    return value;
+  }
+
+private:
+  static size_t index(int channel, int note) {
+    return static_cast<size_t>((channel & 0x0F) * 128 + (note & 0x7F));
+  }
+
+  std::array<std::int8_t, 16 * 128> m_values{};
+};
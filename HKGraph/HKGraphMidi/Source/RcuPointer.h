@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Read-copy-update for one reader on the audio thread and one writer on the message thread.
+//
+// The writer builds a new T off to the side and swaps it in with publish(). The reader wraps each
+// use in a Reader scope and never blocks or frees anything. A replaced T is only deleted by the
+// writer, once the reader is known to be done with it: the reader bumps a counter on entering and
+// on leaving, so an odd count means "inside", and a T retired while the reader was inside is safe
+// as soon as the count moved on.
+template<typename T>
+struct RcuPointer {
+  RcuPointer() = default;
+
+  ~RcuPointer() {
+    delete m_current.load();
+    for (auto &r: m_retired) delete r.pointer;
+  }
+
+  // message thread
+  void publish(std::unique_ptr<T> next) {
+    auto previous = m_current.exchange(next.release());
+    if (previous != nullptr) {
+      m_retired.push_back({previous, m_readers.load()});
+    }
+    collect();
+  }
+
+  // message thread, frees whatever the reader cannot be using anymore
+  void collect() {
+    auto now = m_readers.load();
+    std::erase_if(m_retired, [now](const Retired &r) {
+      auto safe = (r.readers % 2 == 0) || r.readers != now;
+      if (safe) delete r.pointer;
+      return safe;
+    });
+  }
+
+  // audio thread
+  struct Reader {
+    explicit Reader(RcuPointer &rcu) : m_rcu(rcu) {
+      m_rcu.m_readers.fetch_add(1);
+      m_pointer = m_rcu.m_current.load();
+    }
+
+    ~Reader() {
+      m_rcu.m_readers.fetch_add(1);
+    }
+
+    const T *get() const {
+      return m_pointer;
+    }
+
+    const T *operator->() const {
+      return m_pointer;
+    }
+
+  private:
+    RcuPointer &m_rcu;
+    const T *m_pointer;
+  };
+
+private:
+  struct Retired {
+    T *pointer;
+    std::uint64_t readers;
+  };
+
+  std::atomic<T *> m_current{nullptr};
+  std::atomic<std::uint64_t> m_readers{0};
+  std::vector<Retired> m_retired;
+
+  RcuPointer(const RcuPointer &) = delete;
+  RcuPointer &operator=(const RcuPointer &) = delete;
+};
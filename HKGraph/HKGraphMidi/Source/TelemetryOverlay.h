@@ -0,0 +1,49 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "BlockTelemetry.h"
+
+// compact read-out of the block timings, drawn on top of the graph editor
+struct TelemetryOverlay : public juce::Component {
+  static constexpr int WIDTH = 220;
+  static constexpr int HEIGHT = 50;
+
+  TelemetryOverlay() {
+    setInterceptsMouseClicks(false, false);
+  }
+
+  void setSnapshot(const BlockTelemetry::Snapshot &s) {
+    snapshot = s;
+    repaint();
+  }
+
+  void paint(juce::Graphics &g) override {
+    g.setColour(juce::Colour(0xAF1A1A1A));
+    g.fillRoundedRectangle(getLocalBounds().toFloat(), 4.0f);
+    g.setColour(snapshot.over100 > 0 ? juce::Colour(0xFFE27E2A) : juce::Colours::lightgrey);
+    g.setFont(11.0f);
+
+    auto area = getLocalBounds().reduced(6, 4);
+    auto line = area.getHeight() / 3;
+    g.drawText(
+      juce::String::formatted("p50 %.0fus  p99 %.0fus  max %.0fus", snapshot.p50, snapshot.p99, snapshot.max),
+      area.removeFromTop(line), juce::Justification::centredLeft);
+    g.drawText(
+      juce::String::formatted(
+        ">50%% %llu  >80%% %llu  xrun %llu",
+        static_cast<unsigned long long>(snapshot.over50),
+        static_cast<unsigned long long>(snapshot.over80),
+        static_cast<unsigned long long>(snapshot.over100)),
+      area.removeFromTop(line), juce::Justification::centredLeft);
+    if (!snapshot.slowestNode.empty()) {
+      g.drawText(
+        juce::String(snapshot.slowestNode) + juce::String::formatted(" p99 %.0fus", snapshot.slowestNodeP99),
+        area, juce::Justification::centredLeft);
+    }
+  }
+
+private:
+  BlockTelemetry::Snapshot snapshot;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TelemetryOverlay)
+};
@@ -1,65 +1,70 @@
 #pragma once
 #include "Processors.h"
-#include "NodeProcessor.h"
+#include "EventProcessor.h"
 #include "RangeParameter.h"
+#include "RawMidi.h"
+
+struct TransposeProcessor : public EventProcessor, public AutomatableParameters {
+  // what happens to a note shifted past 0 or 127
+  enum class OutOfRange {
+    drop,
+    clamp
+  };
 
-struct TransposeProcessor : public NodeProcessor {
   IntRangeParameter m_parameter;
+  OutOfRange m_outOfRange{OutOfRange::drop};
+  // the note each sounding input note was sent out as, so note-offs follow their note-ons
+  NoteMap m_notes;
 
   explicit TransposeProcessor(Graph *graph) :
-    NodeProcessor(graph),
+    EventProcessor(graph),
     m_parameter(-24, 24, 1, 0) {
   }
 
   TransposeProcessor(Graph *graph, const std::string &name, uint32_t n_ins, uint32_t n_outs)
-    : NodeProcessor(graph, name, n_ins, n_outs),
+    : EventProcessor(graph, name, n_ins, n_outs),
       m_parameter(-24, 24, 1, 0) {
   }
 
   ~TransposeProcessor() override = default;
 
-  void
-  on_data(Graph *graph, const std::optional<const Graph::Node::Pin> &pin, Data &data) override {
+  std::vector<Entry> automatableParameters() override {
+    return {{"transpose", &m_parameter}};
+  }
+
+  EventSubscription subscription(const std::optional<const Node::Pin> &pin) const override {
     juce::ignoreUnused(pin);
-    auto shift = m_parameter.value;
-
-    auto input = std::any_cast<Block>(data);
-    juce::MidiBuffer output;
-    /////
-    if (m_parameter.changed) {
-      for (auto i = 1; i <= 16; i++) {
-        output.addEvent(juce::MidiMessage::allNotesOff(i), 0);
-      }
-      m_parameter.changed = false;
+    return EventSubscription::ofTypes(
+      EventSubscription::noteOff | EventSubscription::noteOn | EventSubscription::polyPressure);
+  }
+
+  void beginBlock(const Block &block) override {
+    m_parameter.beginBlock(block.audioBuffer.getNumSamples(), block.hostBlock());
+  }
+
+  bool processEvent(juce::uint8 *bytes, int size, int samplePosition) override {
+    auto shift = m_parameter.valueAt(samplePosition);
+    auto channel = bytes[0] & 0x0F;
+    auto note = bytes[1];
+    std::int8_t mapped;
+    if (RawMidi::isNoteOn(bytes, size)) {
+      mapped = transpose(note, shift);
+      m_notes.set(channel, note, mapped);
+    } else if (RawMidi::isNoteOff(bytes, size)) {
+      mapped = m_notes.take(channel, note);
+    } else if (size == 3 && (bytes[0] & 0xF0) == 0xA0) { // polyphonic aftertouch follows its note
+      mapped = m_notes.get(channel, note);
+    } else {
+      return true;
     }
-    /////
-    if (input.midiBuffer.getNumEvents() > 0) {
-      for (auto m: input.midiBuffer) {
-        auto message = m.getMessage();
-        if (message.isNoteOn()) {
-          output.addEvent(
-            juce::MidiMessage::noteOn(
-              message.getChannel(),
-              message.getNoteNumber() + shift,
-              message.getFloatVelocity()),
-            m.samplePosition
-          );
-        } else if (message.isNoteOff()) {
-          output.addEvent(
-            juce::MidiMessage::noteOff(
-              message.getChannel(),
-              message.getNoteNumber() + shift),
-            m.samplePosition
-          );
-        } else {
-          output.addEvent(m.getMessage(), m.samplePosition);
-        }
-      }
+    if (mapped == NoteMap::Unknown) { // started before this node saw it
+      mapped = transpose(note, shift);
     }
-    Data result = std::make_any<Block>(input.audioBuffer, output);
-    for (auto &[_, p]: m_outs) {
-      p.async_dispatch(graph, result);
+    if (mapped == NoteMap::Dropped) {
+      return false;
     }
+    bytes[1] = static_cast<juce::uint8>(mapped);
+    return true;
   }
 
   [[nodiscard]] std::string typeId() const override {
@@ -67,11 +72,13 @@ struct TransposeProcessor : public NodeProcessor {
   }
 
   void saveState(juce::ValueTree& nodeTree) override {
-    nodeTree.setProperty("TransposeProcessor::parameter", juce::var(m_parameter.value), nullptr);
+    nodeTree.setProperty("TransposeProcessor::parameter", juce::var(m_parameter.get()), nullptr);
+    nodeTree.setProperty("TransposeProcessor::clamp", juce::var(m_outOfRange == OutOfRange::clamp), nullptr);
   }
 
   void restoreState(const juce::ValueTree& nodeTree) override {
-    m_parameter.value = nodeTree.getProperty("TransposeProcessor::parameter");
+    m_parameter.reset(nodeTree.getProperty("TransposeProcessor::parameter"));
+    m_outOfRange = nodeTree.getProperty("TransposeProcessor::clamp", false) ? OutOfRange::clamp : OutOfRange::drop;
   }
 
   NodeProcessor *clone() override {
@@ -82,10 +89,23 @@ struct TransposeProcessor : public NodeProcessor {
         static_cast<std::uint32_t>(m_ins.size()),
         static_cast<std::uint32_t>(m_outs.size()));
     c->m_muted = m_muted;
-    c->m_parameter.value = m_parameter.value;
+    c->m_parameter.reset(m_parameter.get());
+    c->m_outOfRange = m_outOfRange;
     return c;
   }
 
   juce::Component *createEditor(const GraphViewTheme &theme) override;
 
+private:
+  [[nodiscard]] std::int8_t transpose(int note, int shift) const {
+    auto shifted = note + shift;
+    if (shifted >= 0 && shifted <= 127) {
+      return static_cast<std::int8_t>(shifted);
+    }
+    if (m_outOfRange == OutOfRange::clamp) {
+      return static_cast<std::int8_t>(juce::jlimit(0, 127, shifted));
+    }
+    return NoteMap::Dropped;
+  }
+
 };
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <bit>
+#include "ChannelDemux.h"
+
+// Spreads incoming notes over up to 16 voices, one voice per output channel, without allocating.
+//
+// A note keeps its voice until its note-off, which is routed to the same voice. Free voices are
+// kept on a stack, when none is left voices are shared round robin. Note-ons that start at the
+// same sample position are assigned in ascending pitch order (a counting sort over the 128 notes),
+// so the lowest note of a chord takes the first free voice. Non-note messages are not reordered,
+// they go to every voice.
+struct VoiceAllocator {
+  static constexpr int Voices = ChannelDemux::Outputs;
+  static constexpr int Notes = 128;
+
+  VoiceAllocator() {
+    setNumVoices(Voices);
+  }
+
+  void setNumVoices(int n) {
+    m_numVoices = juce::jlimit(1, Voices, n);
+    reset();
+  }
+
+  void reset() {
+    m_voiceOf.fill(None);
+    m_held.fill(0);
+    m_freeCount = 0;
+    for (auto v{m_numVoices - 1}; v >= 0; --v) {
+      m_free[static_cast<size_t>(m_freeCount++)] = static_cast<std::uint8_t>(v);
+    }
+    m_steal = 0;
+  }
+
+  void process(const EventBuffer &input, ChannelDemux &output) {
+    auto const &columns = input.decoded(m_columns);
+    size_t i = 0;
+    while (i < columns.size()) {
+      auto position = columns.time[i];
+      std::array<std::uint64_t, 2> pending{};
+      for (; i < columns.size() && columns.time[i] == position; ++i) {
+        auto kind = columns.kind[i];
+        auto note = columns.data1[i] & 0x7F;
+        if (kind & EventColumns::noteOn) {
+          pending[static_cast<size_t>(note / 64)] |= bit(note);
+          m_velocity[static_cast<size_t>(note)] = columns.data2[i];
+        } else if (kind & EventColumns::noteOff) {
+          // a note-off also cancels a note-on for the same pitch earlier at this position
+          pending[static_cast<size_t>(note / 64)] &= ~bit(note);
+          noteOff(note, input.getEvent(i), output);
+        } else {
+          broadcast(input.getEvent(i), output);
+        }
+      }
+      for (size_t w = 0; w < pending.size(); ++w) {
+        for (auto bits = pending[w]; bits != 0; bits &= bits - 1) {
+          auto note = static_cast<int>(w * 64) + std::countr_zero(bits);
+          noteOn(note, position, output);
+        }
+      }
+    }
+  }
+
+private:
+  static constexpr std::int8_t None = -1;
+
+  static std::uint64_t bit(int note) {
+    return std::uint64_t{1} << (note % 64);
+  }
+
+  static juce::uint8 status(int type, int voice) {
+    return static_cast<juce::uint8>(type | voice);
+  }
+
+  void noteOn(int note, int position, ChannelDemux &output) {
+    auto &voice = m_voiceOf[static_cast<size_t>(note)];
+    if (voice == None) {
+      voice = allocate();
+      ++m_held[static_cast<size_t>(voice)];
+    }
+    juce::uint8 bytes[]{status(0x90, voice), static_cast<juce::uint8>(note), m_velocity[static_cast<size_t>(note)]};
+    output.add(voice, bytes, 3, position);
+  }
+
+  void noteOff(int note, const juce::MidiMessageMetadata &m, ChannelDemux &output) {
+    auto &voice = m_voiceOf[static_cast<size_t>(note)];
+    if (voice == None) return; // its note-on never went through this allocator
+    juce::uint8 bytes[]{status(m.data[0] & 0xF0, voice), m.data[1], m.data[2]};
+    output.add(voice, bytes, 3, m.samplePosition);
+    if (--m_held[static_cast<size_t>(voice)] == 0) {
+      m_free[static_cast<size_t>(m_freeCount++)] = static_cast<std::uint8_t>(voice);
+    }
+    voice = None;
+  }
+
+  void broadcast(const juce::MidiMessageMetadata &m, ChannelDemux &output) {
+    if (m.data[0] >= 0xF0) {
+      for (auto v{0}; v < m_numVoices; ++v) {
+        output.add(v, m.data, m.numBytes, m.samplePosition);
+      }
+      return;
+    }
+    juce::uint8 bytes[3]{};
+    auto size = std::min(m.numBytes, 3);
+    std::copy_n(m.data, size, bytes);
+    for (auto v{0}; v < m_numVoices; ++v) {
+      bytes[0] = status(m.data[0] & 0xF0, v);
+      output.add(v, bytes, size, m.samplePosition);
+    }
+  }
+
+  std::int8_t allocate() {
+    if (m_freeCount > 0) {
+      return static_cast<std::int8_t>(m_free[static_cast<size_t>(--m_freeCount)]);
+    }
+    auto voice = m_steal;
+    m_steal = (m_steal + 1) % m_numVoices;
+    return static_cast<std::int8_t>(voice);
+  }
+
+  // for blocks that were edited on their way here, see EventColumns
+  EventColumns m_columns;
+  int m_numVoices{Voices};
+  std::array<std::int8_t, Notes> m_voiceOf{};
+  std::array<juce::uint8, Notes> m_velocity{};
+  // notes held per voice, a voice goes back on the free stack when this drops to zero
+  std::array<std::uint8_t, Voices> m_held{};
+  std::array<std::uint8_t, Voices> m_free{};
+  int m_freeCount{0};
+  int m_steal{0};
+};
@@ -4,6 +4,9 @@
 
 struct Measure {
 
+  // a bar is numerator * 64 / denominator units, so a quarter note is always 16
+  static constexpr int unitsPerQuarter = 16;
+
   static int beatsPerBar(const juce::AudioPlayHead::TimeSignature &ts) {
     return ts.numerator;
   }
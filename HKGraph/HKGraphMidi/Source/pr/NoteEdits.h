@@ -0,0 +1,87 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "NoteStore.h"
+
+// A change to some notes of a NoteStore that keeps their number and order: the values of the
+// notes at indices before and after. Applying one side or the other is all undo and redo need.
+struct NotePatch {
+  std::vector<std::uint32_t> indices;
+  NoteStore before;
+  NoteStore after;
+
+  // a patch over the given notes that changes nothing yet, edit after to make it do something
+  static NotePatch of(const NoteStore &notes, std::vector<std::uint32_t> noteIndices) {
+    NotePatch patch;
+    patch.indices = std::move(noteIndices);
+    patch.before = notes.gather(patch.indices);
+    patch.after = patch.before;
+    return patch;
+  }
+
+  [[nodiscard]] bool changes() const {
+    return before.lanes != after.lanes || before.starts != after.starts || before.ends != after.ends ||
+           before.velocities != after.velocities;
+  }
+};
+
+// Edits applied to every note of a store, usually the selected notes gathered into a NotePatch.
+struct NoteEdits {
+
+  // snaps both ends to the nearest step, a note is never shorter than one step
+  static void quantize(NoteStore &notes, int unitsPerQuantize) {
+    auto grid = std::max(1, unitsPerQuantize);
+    auto snap = [grid](int u) {
+      return std::max(0, (u + grid / 2) / grid * grid);
+    };
+    for (size_t i = 0; i < notes.size(); ++i) {
+      notes.starts[i] = snap(notes.starts[i]);
+    }
+    for (size_t i = 0; i < notes.size(); ++i) {
+      notes.ends[i] = std::max(notes.starts[i] + grid, snap(notes.ends[i]));
+    }
+  }
+
+  // moves the notes by semitones, as far as the highest or lowest of them can go
+  static void transpose(NoteStore &notes, int semitones, int nKeys) {
+    if (notes.empty()) return;
+    auto [lowest, highest] = std::minmax_element(std::begin(notes.lanes), std::end(notes.lanes));
+    // lane 0 is the highest note
+    auto shift = juce::jlimit(-(nKeys - 1 - *highest), *lowest, semitones);
+    for (auto &lane: notes.lanes) {
+      lane -= shift;
+    }
+  }
+
+  static void scaleVelocity(NoteStore &notes, float factor) {
+    for (auto &v: notes.velocities) {
+      v = juce::jlimit(0.0f, 1.0f, v * factor);
+    }
+  }
+
+  // adds a random offset of at most amount to every velocity
+  static void humanize(NoteStore &notes, float amount, juce::Random &random) {
+    for (auto &v: notes.velocities) {
+      v = juce::jlimit(0.0f, 1.0f, v + (random.nextFloat() * 2.0f - 1.0f) * amount);
+    }
+  }
+
+  // stretches every note up to the start of the next one, the last ones keep their length
+  static void legato(NoteStore &notes) {
+    std::vector<std::uint32_t> order(notes.size());
+    std::iota(std::begin(order), std::end(order), 0);
+    std::sort(std::begin(order), std::end(order), [&notes](std::uint32_t a, std::uint32_t b) {
+      return notes.starts[a] < notes.starts[b];
+    });
+    // notes starting together all end where the next start is
+    size_t next = 0;
+    for (size_t k = 0; k < order.size(); ++k) {
+      auto start = notes.starts[order[k]];
+      while (next < order.size() && notes.starts[order[next]] <= start) ++next;
+      if (next < order.size()) {
+        notes.ends[order[k]] = notes.starts[order[next]];
+      }
+    }
+  }
+
+};
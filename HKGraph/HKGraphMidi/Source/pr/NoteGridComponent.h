@@ -4,9 +4,22 @@
 #include "GraphViewTheme.h"
 #include "SelectionComponent.h"
 #include "PianoRollTheme.h"
-#include "NoteComponent.h"
+#include "NoteModel.h"
+#include "NoteStore.h"
+#include "NoteEdits.h"
+#include "NoteIndex.h"
+#include "TileCache.h"
 #include "Measure.h"
 
+// Draws and edits the notes of a piano roll. Notes live in a NoteStore, not in components: painting,
+// hit-testing and rubber-band selection all go through a NoteIndex, so they only look at the notes
+// in the area concerned. Notes being dragged or resized are drawn at their preview position and
+// written back, and the index rebuilt, when the mouse is released. The lanes and grid lines under
+// the notes come from a TileCache.
+//
+// Every edit goes through an UndoManager. Mouse edits and the bulk edits over the selection
+// (quantize, transpose, velocity, legato) are NotePatches; adding and removing notes are their own
+// actions, so the indices the patches refer to stay valid along the history.
 struct NoteGridComponent : juce::Component {
 
   const juce::Colour cWhiteKeysBg{PianoRollTheme::whiteKeysBg};
@@ -16,6 +29,7 @@ struct NoteGridComponent : juce::Component {
   const juce::Colour cBarFg{PianoRollTheme::vBarFg};
   const juce::Colour cBeatFg{PianoRollTheme::vBeatFg};
   const juce::Colour cQuantizeFg{PianoRollTheme::vQuantizeFg};
+  const juce::Colour cSelectedBg{PianoRollTheme::noteSelectedBg};
 
   juce::AudioPlayHead::TimeSignature timeSignature{};
   float playHeadPosition{0.0f};
@@ -29,132 +43,16 @@ struct NoteGridComponent : juce::Component {
   const juce::MouseCursor rightEdgeResizeCursor{juce::MouseCursor::StandardCursorType::RightEdgeResizeCursor};
   const juce::MouseCursor leftEdgeResizeCursor{juce::MouseCursor::StandardCursorType::LeftEdgeResizeCursor};
   const juce::MouseCursor normalCursor{juce::MouseCursor::StandardCursorType::NormalCursor};
-  std::vector<NoteComponent *> notes;
   bool noteMultiSelectionOn{false};
   GraphViewTheme theme{};
   SelectionComponent selector{theme.cSelectionBackground};
+  // called after any edit of the notes
+  std::function<void()> onNotesChanged;
+  // called with the unit the last note ends at whenever the notes change, edited or not
+  std::function<void(int)> onExtentChanged;
 
-  struct ChildrenMouseListener : juce::MouseListener {
-    NoteGridComponent *parent;
-
-    explicit ChildrenMouseListener(NoteGridComponent *p) : juce::MouseListener(), parent(p) {}
-
-    ~ChildrenMouseListener() override = default;
-
-    void mouseMove(const juce::MouseEvent &e) override {
-      if (auto note = dynamic_cast<NoteComponent *>(e.originalComponent)) {
-        parent->updateNoteModel(note);
-      }
-    }
-
-    void mouseExit(const juce::MouseEvent &e) override {
-      if (auto note = dynamic_cast<NoteComponent *>(e.originalComponent)) {
-        parent->updateNoteModel(note);
-      }
-    }
-
-    void mouseDown(const juce::MouseEvent &e) override {
-      if (auto note = dynamic_cast<NoteComponent *>(e.originalComponent)) {
-        parent->noteMouseDown(note, e);
-        parent->updateNoteModel(note);
-      }
-    }
-
-    void mouseDrag(const juce::MouseEvent &e) override {
-      if (auto note = dynamic_cast<NoteComponent *>(e.originalComponent)) {
-        parent->noteMouseDrag(note, e);
-      }
-    }
-
-    void mouseUp(const juce::MouseEvent &e) override {
-      if (auto note = dynamic_cast<NoteComponent *>(e.originalComponent)) {
-        parent->noteMouseUp(note, e);
-        if (parent->noteMultiSelectionOn) {
-          for (auto &n: parent->notes) {
-            parent->updateNoteModel(n);
-            n->repaint();
-          }
-        } else {
-          parent->updateNoteModel(note);
-        }
-      }
-    }
-
-    void mouseDoubleClick(const juce::MouseEvent &e) override {
-      if (auto note = dynamic_cast<NoteComponent *>(e.originalComponent)) {
-        parent->noteMouseDoubleClick(note, e);
-        parent->updateNoteModel(note);
-      }
-    }
-
-  };
-
-  std::unique_ptr<ChildrenMouseListener> mouseListener;
-
-  struct NoteConstrainer : juce::ComponentBoundsConstrainer {
-    NoteGridComponent *parent;
-
-    explicit NoteConstrainer(NoteGridComponent *p) : juce::ComponentBoundsConstrainer(), parent(p) {}
-
-    ~NoteConstrainer() override = default;
-
-    void checkBounds(juce::Rectangle<int> &bounds,
-                     const juce::Rectangle<int> &previousBounds,
-                     const juce::Rectangle<int> &,
-                     bool,
-                     bool isStretchingLeft,
-                     bool,
-                     bool isStretchingRight) override {
-      auto xp = previousBounds.getX();
-      auto yp = previousBounds.getY();
-      auto wp = previousBounds.getWidth();
-      auto hp = previousBounds.getHeight();
-
-      auto x = bounds.getX();
-      auto w = bounds.getWidth();
-
-      // boundaries
-      if (x < 0) {
-        x = 0;
-        bounds.setBounds(x, yp, wp, hp);
-        return;
-      }
-
-      if (x + w > parent->getWidth()) {
-        bounds.setBounds(x, yp, parent->getWidth() - x, hp);
-        return;
-      }
-
-      if (parent->freeResize) {
-        if (w < static_cast<int>(parent->unit)) {
-          bounds.setBounds(xp, yp, wp, hp);
-        }
-      } else {
-        // snap
-        auto min = Measure::quantizeWidth(parent->timeSignature, parent->quantize, parent->unit);
-        if (isStretchingLeft) {
-          auto xs = parent->nearestBar(x, w);
-          auto xr = x + w;
-          if (xr > xs) {
-            bounds.setLeft(xs);
-          } else {
-            bounds.setBounds(xp, yp, wp, hp);
-          }
-        } else if (isStretchingRight) {
-          auto xr = x + w;
-          auto xs = parent->nearestBar(xr, 0);
-          w = xs - x;
-          if (w >= min) {
-            bounds.setBounds(x, yp, w, hp);
-          } else {
-            bounds.setBounds(xp, yp, wp, hp);
-          }
-        }
-      }
-    }
-  };
-
-  std::unique_ptr<NoteConstrainer> noteConstrainer;
+  // the width of the grab area at either end of a note
+  static constexpr int edgeWidth = 2;
 
   NoteGridComponent(
     juce::AudioPlayHead::TimeSignature ts,
@@ -169,23 +67,24 @@ struct NoteGridComponent : juce::Component {
     nKeys(numberOfKeys),
     bars(numberOfBars),
     unit(gridUnit),
-    quantize(quantization),
-    mouseListener(new ChildrenMouseListener(this)),
-    noteConstrainer(new NoteConstrainer(this)) {
-    // TODO fix size
-    auto unitsPerBar = (static_cast<int>(timeSignature.numerator) * 64) / static_cast<int>(timeSignature.denominator);
-    auto barWidth = unitsPerBar * static_cast<int>(unit);
-    setSize(bars * static_cast<int>(barWidth), numberOfKeys * laneHeight);
+    quantize(quantization) {
+    updateSize();
+    setWantsKeyboardFocus(true);
   }
 
-  ~NoteGridComponent() override {
-    for (auto &n: notes) {
-      n->removeMouseListener(mouseListener.get());
-      delete n;
-    }
-  }
+  ~NoteGridComponent() override = default;
 
   void paint(juce::Graphics &g) override {
+    m_background.paint(g, getLocalBounds());
+    paintNotes(g, g.getClipBounds());
+
+    // draw play head
+    g.setColour(juce::Colours::white);
+    g.fillRect(playHeadBounds());
+  }
+
+  // the lanes and grid lines, cached in tiles
+  void paintBackground(juce::Graphics &g, const juce::Rectangle<int> &area) const {
     auto bounds = getLocalBounds();
     auto w = bounds.getWidth();
 
@@ -249,161 +148,193 @@ struct NoteGridComponent : juce::Component {
       ++i;
     }
 
+    // only the grid lines inside the area
     auto unitsPerBar = Measure::unitsPerBar(timeSignature);
     auto unitsPerBeat = Measure::unitsPerBeat(timeSignature);
     auto unitsPerQuantize = Measure::unitsPerQuantize(timeSignature, quantize);
-    for (auto bar = 0; bar < bars; ++bar) {
-      for (auto u = 0; u < unitsPerBar; ++u) {
-        auto onBar = u == 0;
-        auto onBeat = u % unitsPerBeat == 0;
-        auto onQuantize = u % unitsPerQuantize == 0;
-        if (onBar) {
-          g.setColour(cBarFg);
-          g.fillRect(
-            static_cast<float>(x),
-            0.0f,
-            vBarSeparatorWidth,
-            static_cast<float>(bounds.getHeight()));
-        } else if (onBeat) {
-          g.setColour(cBeatFg);
-          g.fillRect(
-            static_cast<float>(x),
-            0.0f,
-            vBarSeparatorWidth,
-            static_cast<float>(bounds.getHeight()));
-        } else if (onQuantize) {
-          g.setColour(cQuantizeFg);
-          g.fillRect(
-            static_cast<float>(x),
-            0.0f,
-            vBarSeparatorWidth,
-            static_cast<float>(bounds.getHeight()));
-        }
-        x += unit;
-      }
+    auto firstUnit = std::max(0, area.getX() / unit);
+    auto lastUnit = std::min(bars * unitsPerBar, area.getRight() / unit + 1);
+    for (auto u = firstUnit; u < lastUnit; ++u) {
+      auto inBar = u % unitsPerBar;
+      auto onBar = inBar == 0;
+      auto onBeat = inBar % unitsPerBeat == 0;
+      auto onQuantize = inBar % unitsPerQuantize == 0;
+      if (!onBar && !onBeat && !onQuantize) continue;
+      g.setColour(onBar ? cBarFg : onBeat ? cBeatFg : cQuantizeFg);
+      g.fillRect(
+        static_cast<float>(u * unit),
+        0.0f,
+        vBarSeparatorWidth,
+        static_cast<float>(bounds.getHeight()));
     }
-
-    // draw play head
-    g.setColour(juce::Colours::white);
-    g.fillRect(
-      playHeadPosition,
-      0.0f,
-      PianoRollTheme::vBarSeparatorWidth / scaledWidth * 0.5f,
-      static_cast<float>(bounds.getHeight())
-    );
-
   }
 
   void resized() override {
   }
 
-  void mouseDown(const juce::MouseEvent &e) override {
-    for (auto &n: notes) {
-      n->selected = false;
-      n->repaint();
-    }
-    noteMultiSelectionOn = false;
-    // selector
-    auto position = e.getMouseDownPosition();
-    selector.setBounds(position.x, position.y, 10, 10);
-    addAndMakeVisible(selector);
+  void mouseMove(const juce::MouseEvent &e) override {
+    auto hit = hitNote(e.getPosition());
+    auto edge = hit.has_value() ? hit->edge : Edge::none;
+    setMouseCursor(edge == Edge::left ? leftEdgeResizeCursor : edge == Edge::right ? rightEdgeResizeCursor : normalCursor);
   }
 
-  void mouseDoubleClick(const juce::MouseEvent &e) override {
-    addNote(e);
+  void mouseDown(const juce::MouseEvent &e) override {
+    grabKeyboardFocus();
+    auto hit = hitNote(e.getPosition());
+    m_dragOffset = {};
+    if (!hit.has_value()) {
+      clearSelection();
+      noteMultiSelectionOn = false;
+      // selector
+      auto position = e.getMouseDownPosition();
+      selector.setBounds(position.x, position.y, 10, 10);
+      addAndMakeVisible(selector);
+      m_drag = Drag::select;
+      repaint();
+      return;
+    }
+    m_dragNote = hit->index;
+    if (hit->edge != Edge::none) {
+      freeResize = e.mods.isShiftDown();
+      m_resizeBounds = noteBounds(hit->index);
+      m_drag = hit->edge == Edge::left ? Drag::resizeLeft : Drag::resizeRight;
+      return;
+    }
+    // dragging a selected note moves the whole selection, any other note is selected on its own
+    if (!noteMultiSelectionOn || !m_selected[hit->index]) {
+      noteMultiSelectionOn = false;
+      clearSelection();
+      select(hit->index);
+    }
+    m_drag = Drag::move;
+    repaint();
   }
 
   void mouseDrag(const juce::MouseEvent &e) override {
-    auto position = e.getMouseDownPosition();
     auto offset = e.getOffsetFromDragStart();
-    selector.calculateBounds(position, offset);
-    // handle node selection
-    auto numSelectedNotes = 0;
-    for (auto &n: notes) {
-      auto selected = selector.getBounds().intersects(n->getBounds());
-      n->selected = selected;
-      n->repaint();
-      if (selected) ++numSelectedNotes;
+    switch (m_drag) {
+      case Drag::select: {
+        selector.calculateBounds(e.getMouseDownPosition(), offset);
+        selectArea(selector.getBounds());
+        noteMultiSelectionOn = !m_selection.empty();
+        break;
+      }
+      case Drag::move:
+        // notes follow the mouse freely in time and lane by lane
+        m_dragOffset = {offset.x, juce::roundToInt(static_cast<float>(offset.y) / static_cast<float>(laneHeight)) * laneHeight};
+        break;
+      case Drag::resizeLeft:
+      case Drag::resizeRight:
+        m_resizeBounds = resizedBounds(noteBounds(m_dragNote), offset.x, m_drag == Drag::resizeLeft);
+        break;
+      case Drag::none:
+        return;
     }
-    noteMultiSelectionOn = numSelectedNotes > 0;
+    repaint();
   }
 
-  void mouseUp(const juce::MouseEvent &) override {
-    removeChildComponent(&selector);
-  }
-
-
-  void noteMouseDown(NoteComponent *note, const juce::MouseEvent &e) {
-    if (noteMultiSelectionOn && !note->selected) {
-      noteMultiSelectionOn = false;
-    }
-    if (noteMultiSelectionOn && note->selected) {
-      for (auto &n: notes) {
-        n->dragMouseDownPosition = e.getEventRelativeTo(n).getMouseDownPosition();
-      }
-    } else {
-      note->selected = true;
-      note->repaint();
-      for (auto &n: notes) {
-        n->dragMouseDownPosition = e.getEventRelativeTo(n).getMouseDownPosition();
-        if (n != note && n->selected) {
-          n->selected = false;
-          n->repaint();
+  void mouseUp(const juce::MouseEvent &e) override {
+    auto drag = m_drag;
+    m_drag = Drag::none;
+    switch (drag) {
+      case Drag::select:
+        removeChildComponent(&selector);
+        break;
+      case Drag::move:
+        if (m_dragOffset != juce::Point<int>{}) {
+          auto patch = NotePatch::of(m_notes, selectedIndices());
+          for (size_t k = 0; k < patch.indices.size(); ++k) {
+            auto bounds = noteBounds(patch.indices[k]) + m_dragOffset;
+            auto x = e.mods.isShiftDown() ? juce::jlimit(0, getWidth() - bounds.getWidth(), bounds.getX())
+                                          : nearestBar(bounds.getX(), bounds.getWidth());
+            setNoteBounds(patch.after, k, bounds.withPosition(x, nearestLane(bounds.getY())));
+          }
+          apply(std::move(patch));
         }
-      }
+        break;
+      case Drag::resizeLeft:
+      case Drag::resizeRight:
+        if (m_resizeBounds != noteBounds(m_dragNote)) {
+          auto patch = NotePatch::of(m_notes, {static_cast<std::uint32_t>(m_dragNote)});
+          setNoteBounds(patch.after, 0, m_resizeBounds);
+          apply(std::move(patch));
+        }
+        freeResize = false;
+        break;
+      case Drag::none:
+        break;
     }
+    m_dragOffset = {};
+    repaint();
   }
 
-  void noteMouseDrag(NoteComponent *note, const juce::MouseEvent &e) {
-    if (noteMultiSelectionOn) {
-      for (auto &n: notes) {
-        if (n->selected) startNoteDrag(n, e);
-      }
+  void mouseDoubleClick(const juce::MouseEvent &e) override {
+    auto hit = hitNote(e.getPosition());
+    if (hit.has_value()) {
+      removeNote(hit->index);
     } else {
-      startNoteDrag(note, e);
+      addNote(e);
     }
   }
 
-  void noteMouseUp(NoteComponent *note, const juce::MouseEvent &e) {
-    if (note->dragging) {
-      if (noteMultiSelectionOn) {
-        for (auto &n: notes) {
-          if (n->selected) endNoteDrag(n, e);
-        }
-      } else {
-        endNoteDrag(note, e);
-      }
+  void mouseWheelMove(const juce::MouseEvent &e, const juce::MouseWheelDetails &wheel) override {
+    auto hit = e.mods.isShiftDown() ? hitNote(e.getPosition()) : std::nullopt;
+    if (!hit.has_value()) {
+      juce::Component::mouseWheelMove(e, wheel);
+      return;
     }
+    auto patch = NotePatch::of(m_notes, {static_cast<std::uint32_t>(hit->index)});
+    auto reversed = wheel.isReversed ? -1.0f : 1.0f;
+    auto delta = juce::jmap(reversed * wheel.deltaX, 0.0f, 1.0f); // weird
+    patch.after.velocities[0] = juce::jlimit(0.0f, 1.0f, patch.after.velocities[0] - reversed * delta);
+    apply(std::move(patch));
   }
 
-  void noteMouseDoubleClick(NoteComponent *note, const juce::MouseEvent &) {
-    removeNote(note);
-  }
-
-  void startNoteDrag(NoteComponent *note, const juce::MouseEvent &e) const {
-    auto localMousePosition = e.getEventRelativeTo(note).getPosition();
-    auto bounds = note->getBounds();
-    bounds += localMousePosition - note->dragMouseDownPosition;
-    note->dragging = true;
-    updateNoteModel(note);
-    note->setBounds(bounds);
-  }
+  bool keyPressed(const juce::KeyPress &key) override {
+    auto code = key.getKeyCode();
+    auto commandDown = key.getModifiers().isCommandDown();
+    auto shiftDown = key.getModifiers().isShiftDown();
 
-  void endNoteDrag(NoteComponent *note, const juce::MouseEvent &e) const {
-    //auto mousePosition = e.getEventRelativeTo(this).getPosition();
-    auto notePosition = note->getPosition();
-    auto x = nearestBar(notePosition.x, note->getWidth());
-    if (e.mods.isShiftDown()) {
-      x = notePosition.x;
+    if (code == juce::KeyPress::deleteKey || code == juce::KeyPress::backspaceKey) {
+      removeSelected();
+    }
+      // cmd 'z', cmd shift 'z'
+    else if (code == 90 && commandDown) {
+      if (shiftDown) redo();
+      else undo();
+    }
+      // cmd 'a'
+    else if (code == 65 && commandDown) {
+      selectAll();
+    }
+      // up and down, shift for octaves
+    else if (code == juce::KeyPress::upKey || code == juce::KeyPress::downKey) {
+      auto semitones = shiftDown ? 12 : 1;
+      transposeSelected(code == juce::KeyPress::upKey ? semitones : -semitones);
+    }
+      // 'q'
+    else if (code == 81 && !commandDown) {
+      quantizeSelected();
     }
-    note->setBounds(
-      x,
-      //nearestLane(mousePosition.y),
-      nearestLane(notePosition.y),
-      note->getWidth(),
-      note->getHeight()
-    );
-    note->dragging = false;
+      // 'l'
+    else if (code == 76 && !commandDown) {
+      legatoSelected();
+    }
+      // 'h'
+    else if (code == 72 && !commandDown) {
+      humanizeSelected(0.1f);
+    }
+      // '+' or '='
+    else if ((code == 43 || code == 61) && !commandDown) {
+      scaleSelectedVelocity(1.1f);
+    }
+      // '-'
+    else if (code == 45 && !commandDown) {
+      scaleSelectedVelocity(0.9f);
+    } else {
+      return false;
+    }
+    return true;
   }
 
   [[nodiscard]] int nearestLane(int y) const {
@@ -426,47 +357,439 @@ struct NoteGridComponent : juce::Component {
   void addNote(const juce::MouseEvent &e) {
     auto relativeEvent = e.getEventRelativeTo(this);
     auto position = relativeEvent.getPosition();
-    auto n = new NoteComponent(noteConstrainer.get());
-    n->addMouseListener(mouseListener.get(), false);
     auto barWidth = Measure::barWidth(timeSignature, unit);
-    n->setBounds(nearestBar(position.x, barWidth), nearestLane(position.y), barWidth, laneHeight);
-    updateNoteModel(n);
-    n->callback = [this](NoteComponent *, bool freeResizeOn) {
-      this->freeResize = freeResizeOn;
-    };
-    notes.push_back(n);
-    addAndMakeVisible(n);
+    NoteStore added;
+    added.append(NoteModel{});
+    setNoteBounds(added, 0, {nearestBar(position.x, barWidth), nearestLane(position.y), barWidth, laneHeight});
+    perform(new InsertAction(*this, std::move(added)));
   }
 
-  void removeNote(NoteComponent *note) {
-    auto p = std::erase_if(notes, [&](auto &n) { return n == note; });
-    if (p != 0) {
-      note->removeMouseListener(mouseListener.get());
-      removeChildComponent(note);
-      delete note;
-    }
+  void removeNote(size_t index) {
+    perform(new EraseAction(*this, {static_cast<std::uint32_t>(index)}));
+  }
+
+  void removeSelected() {
+    if (m_selection.empty()) return;
+    perform(new EraseAction(*this, selectedIndices()));
+  }
+
+  // replaces the notes, for showing notes kept elsewhere; nothing is reported and the undo history starts over
+  void setNotes(const std::vector<NoteModel> &models) {
+    m_undo.clearUndoHistory();
+    m_notes = NoteStore::of(models);
+    m_selected.assign(m_notes.size(), 0);
+    m_selection.clear();
+    rebuildIndex();
+    repaint();
+  }
+
+  // adds notes as one undoable step
+  void addNotes(const std::vector<NoteModel> &models) {
+    if (models.empty()) return;
+    perform(new InsertAction(*this, NoteStore::of(models)));
+  }
+
+  [[nodiscard]] std::vector<NoteModel> models() const {
+    return m_notes.models();
+  }
+
+  void selectAll() {
+    std::fill(std::begin(m_selected), std::end(m_selected), 1);
+    m_selection.resize(m_notes.size());
+    std::iota(std::begin(m_selection), std::end(m_selection), 0);
+    noteMultiSelectionOn = !m_selection.empty();
+    repaint();
+  }
+
+  void quantizeSelected() {
+    editSelected([this](NoteStore &notes) {
+      NoteEdits::quantize(notes, Measure::unitsPerQuantize(timeSignature, quantize));
+    });
+  }
+
+  void transposeSelected(int semitones) {
+    editSelected([this, semitones](NoteStore &notes) {
+      NoteEdits::transpose(notes, semitones, nKeys);
+    });
   }
 
-  void updateNoteModel(NoteComponent *note) const {
-    note->model.start = note->getX();
-    note->model.end = note->getWidth();
-    note->model.lane = note->getY() / laneHeight;
-    note->model.scaledWidth = scaledWidth;
-    note->model.scaledHeight = scaledHeight;
+  void scaleSelectedVelocity(float factor) {
+    editSelected([factor](NoteStore &notes) {
+      NoteEdits::scaleVelocity(notes, factor);
+    });
+  }
+
+  void humanizeSelected(float amount) {
+    editSelected([this, amount](NoteStore &notes) {
+      NoteEdits::humanize(notes, amount, m_random);
+    });
+  }
+
+  void legatoSelected() {
+    editSelected([](NoteStore &notes) {
+      NoteEdits::legato(notes);
+    });
+  }
+
+  void undo() {
+    m_undo.undo();
+  }
+
+  void redo() {
+    m_undo.redo();
+  }
+
+  void notesChanged() const {
+    if (onNotesChanged != nullptr) {
+      onNotesChanged();
+    }
   }
 
   void setScale(float widthFactor, float heightFactor) {
     scaledWidth = widthFactor;
     scaledHeight = heightFactor;
-    for (auto &n: notes) {
-      n->model.scaledWidth = scaledWidth;
-      n->model.scaledHeight = scaledHeight;
-      n->repaint();
-    }
+    m_background.setScale(widthFactor, heightFactor);
+    repaint();
+  }
+
+  void setTimeSignature(int numerator, int denominator) {
+    timeSignature.numerator = numerator;
+    timeSignature.denominator = denominator;
+    m_background.invalidate();
+    updateSize();
+    repaint();
+  }
+
+  // the length of the grid, notes past the end are kept but not shown
+  void setBars(int numberOfBars) {
+    bars = numberOfBars;
+    updateSize();
+  }
+
+  void setQuantize(int v) {
+    quantize = v;
+    m_background.invalidate();
+    repaint();
+  }
+
+  // only repaints the strips under the old and the new play head
+  void setPlayHeadPosition(float x) {
+    repaint(playHeadBounds().getSmallestIntegerContainer());
+    playHeadPosition = x;
+    repaint(playHeadBounds().getSmallestIntegerContainer());
   }
 
 private:
+  enum class Drag {
+    none, select, move, resizeLeft, resizeRight
+  };
+
+  enum class Edge {
+    none, left, right
+  };
+
+  struct Hit {
+    size_t index;
+    Edge edge;
+  };
+
+  void updateSize() {
+    setSize(bars * Measure::barWidth(timeSignature, unit), nKeys * laneHeight);
+  }
+
+  void rebuildIndex() {
+    m_index.rebuild(m_notes);
+    if (onExtentChanged != nullptr) {
+      onExtentChanged(m_index.end());
+    }
+  }
+
+  [[nodiscard]] juce::Rectangle<float> playHeadBounds() const {
+    return {playHeadPosition, 0.0f, PianoRollTheme::vBarSeparatorWidth / scaledWidth * 0.5f, static_cast<float>(getHeight())};
+  }
+
+  [[nodiscard]] juce::Rectangle<int> noteBounds(size_t i) const {
+    return {m_notes.starts[i] * unit, m_notes.lanes[i] * laneHeight, (m_notes.ends[i] - m_notes.starts[i]) * unit, laneHeight};
+  }
+
+  void setNoteBounds(NoteStore &notes, size_t i, const juce::Rectangle<int> &bounds) const {
+    notes.starts[i] = bounds.getX() / unit;
+    notes.ends[i] = bounds.getRight() / unit;
+    notes.lanes[i] = bounds.getY() / laneHeight;
+  }
+
+  // the topmost note under position, and whether the position is on one of its ends
+  [[nodiscard]] std::optional<Hit> hitNote(juce::Point<int> position) const {
+    auto lane = position.y / laneHeight;
+    auto u = position.x / unit;
+    std::optional<Hit> hit;
+    m_index.query(lane, lane + 1, u, u + 1, [&](size_t i) {
+      auto bounds = noteBounds(i);
+      if (!bounds.contains(position)) return;
+      auto edge = position.x < bounds.getX() + edgeWidth ? Edge::left
+                : position.x >= bounds.getRight() - edgeWidth ? Edge::right
+                : Edge::none;
+      hit = Hit{i, edge};
+    });
+    return hit;
+  }
+
+  // the bounds a note would get with one of its ends moved by dx, snapped unless freeResize
+  [[nodiscard]] juce::Rectangle<int> resizedBounds(const juce::Rectangle<int> &bounds, int dx, bool left) const {
+    if (left) {
+      auto x = juce::jlimit(0, bounds.getRight() - 1, bounds.getX() + dx);
+      if (!freeResize) {
+        x = nearestBar(x, bounds.getRight() - x);
+      }
+      return bounds.getRight() - x >= unit ? bounds.withLeft(x) : bounds;
+    }
+    auto right = juce::jlimit(bounds.getX() + 1, getWidth(), bounds.getRight() + dx);
+    if (freeResize) {
+      return bounds.withRight(std::max(bounds.getX() + unit, right));
+    }
+    auto min = Measure::quantizeWidth(timeSignature, quantize, unit);
+    auto snapped = nearestBar(right, 0);
+    return snapped - bounds.getX() >= min ? bounds.withRight(snapped) : bounds;
+  }
+
+  // whether a note is drawn somewhere else than its model says, while it is being dragged
+  [[nodiscard]] bool inFlight(size_t i) const {
+    return (m_drag == Drag::move && m_selected[i] && m_dragOffset != juce::Point<int>{}) ||
+           ((m_drag == Drag::resizeLeft || m_drag == Drag::resizeRight) && i == m_dragNote);
+  }
+
+  void paintNotes(juce::Graphics &g, const juce::Rectangle<int> &clip) {
+    auto laneBegin = clip.getY() / laneHeight;
+    auto laneEnd = clip.getBottom() / laneHeight + 1;
+    auto begin = clip.getX() / unit;
+    auto end = clip.getRight() / unit + 1;
+    m_visible.clear();
+    m_index.query(laneBegin, laneEnd, begin, end, [&](size_t i) {
+      if (!inFlight(i)) m_visible.push_back({i, noteBounds(i)});
+    });
+    // dragged notes go on top
+    if (m_drag == Drag::move && m_dragOffset != juce::Point<int>{}) {
+      for (auto i: m_selection) {
+        auto bounds = noteBounds(i) + m_dragOffset;
+        if (bounds.intersects(clip)) m_visible.push_back({i, bounds});
+      }
+    } else if (m_drag == Drag::resizeLeft || m_drag == Drag::resizeRight) {
+      m_visible.push_back({m_dragNote, m_resizeBounds});
+    }
+
+    for (auto const &[i, bounds]: m_visible) {
+      paintNote(g, m_notes.velocities[i], bounds, m_selected[i] != 0);
+    }
+
+    // note names, only once they fit the lane at the current zoom
+    auto fh = g.getCurrentFont().getHeight();
+    if (static_cast<float>(laneHeight) * scaledHeight < fh) return;
+    juce::Graphics::ScopedSaveState state(g);
+    g.addTransform(juce::AffineTransform().scaled(1.0f / scaledWidth, 1.0f / scaledHeight)); // prevent font transformation
+    auto toScreen = juce::AffineTransform().scaled(scaledWidth, scaledHeight);
+    for (auto const &[i, bounds]: m_visible) {
+      // font colour is the reverse of the background colour
+      g.setColour(m_selected[i] ? noteColour(m_notes.velocities[i]) : cSelectedBg);
+      g.drawText(
+        juce::MidiMessage::getMidiNoteName(127 - m_notes.lanes[i], true, true, 3),
+        bounds.toFloat().transformedBy(toScreen).withTrimmedLeft(4.0f),
+        juce::Justification::centredLeft,
+        false);
+    }
+  }
+
+  void paintNote(juce::Graphics &g, float velocity, const juce::Rectangle<int> &bounds, bool selected) const {
+    auto borderThickness = 1;
+    if (selected) {
+      g.setColour(cSelectedBg);
+      g.fillRect(bounds);
+      return;
+    }
+    auto cUnselected = noteColour(velocity);
+    g.setColour(cUnselected);
+    g.fillRect(bounds);
+    // the part past the velocity is drawn brighter
+    auto vw = static_cast<int>(juce::jmap(velocity, 0.0f, static_cast<float>(bounds.getWidth())));
+    g.setColour(cUnselected.brighter());
+    g.fillRect(juce::Rectangle<int>(
+      bounds.getX() + vw,
+      bounds.getY() + borderThickness,
+      bounds.getWidth() - vw - borderThickness,
+      bounds.getHeight() - (2 * borderThickness)));
+  }
+
+  static juce::Colour noteColour(float v) {
+    auto velocity = static_cast<int>(juce::jmap(v, 1.0f, 100.0f));
+    auto darkness = static_cast<float>((velocity % 10) * 0.01);
+    static const std::array<juce::uint32, 10> colours{
+      0xFF43426C, 0xFF557DC2, 0xFF46A0B4, 0xFF42B187, 0xFF46B446,
+      0xFF80AA3C, 0xFFAA963C, 0xFFB8744A, 0xFFC15D53, 0xFFC45757
+    };
+    if (velocity < 0 || velocity > 100) return juce::Colours::white;
+    // the upper bound of each range of 10 belongs to the lower range
+    auto bucket = std::max(0, (velocity - 1) / 10);
+    return juce::Colour(colours[static_cast<size_t>(bucket)]).darker(darkness);
+  }
+
+  void clearSelection() {
+    for (auto i: m_selection) {
+      m_selected[i] = 0;
+    }
+    m_selection.clear();
+  }
+
+  void select(size_t i) {
+    if (!m_selected[i]) {
+      m_selected[i] = 1;
+      m_selection.push_back(i);
+    }
+  }
+
+  void selectArea(const juce::Rectangle<int> &area) {
+    clearSelection();
+    m_index.query(
+      area.getY() / laneHeight, area.getBottom() / laneHeight + 1,
+      area.getX() / unit, area.getRight() / unit + 1,
+      [&](size_t i) {
+        if (noteBounds(i).intersects(area)) select(i);
+      });
+  }
+
+  // the selected notes, in order
+  [[nodiscard]] std::vector<std::uint32_t> selectedIndices() const {
+    std::vector<std::uint32_t> indices;
+    indices.reserve(m_selection.size());
+    for (size_t i = 0; i < m_selected.size(); ++i) {
+      if (m_selected[i]) indices.push_back(static_cast<std::uint32_t>(i));
+    }
+    return indices;
+  }
+
+  // runs f over the selected notes gathered into a store, as one undoable step
+  template<typename F>
+  void editSelected(F &&f) {
+    if (m_selection.empty()) return;
+    auto patch = NotePatch::of(m_notes, selectedIndices());
+    f(patch.after);
+    apply(std::move(patch));
+  }
+
+  void apply(NotePatch patch) {
+    if (patch.changes()) {
+      perform(new PatchAction(*this, std::move(patch)));
+    }
+  }
+
+  void perform(juce::UndoableAction *action) {
+    m_undo.beginNewTransaction();
+    m_undo.perform(action);
+  }
+
+  // changes the values of some notes
+  struct PatchAction : juce::UndoableAction {
+    PatchAction(NoteGridComponent &grid, NotePatch patch) : m_grid(grid), m_patch(std::move(patch)) {}
+
+    bool perform() override {
+      m_grid.m_notes.scatter(m_patch.indices, m_patch.after);
+      m_grid.notesEdited();
+      return true;
+    }
+
+    bool undo() override {
+      m_grid.m_notes.scatter(m_patch.indices, m_patch.before);
+      m_grid.notesEdited();
+      return true;
+    }
+
+    int getSizeInUnits() override {
+      return static_cast<int>(m_patch.indices.size()) * 2 + 1;
+    }
+
+    NoteGridComponent &m_grid;
+    NotePatch m_patch;
+  };
+
+  // adds notes after the existing ones
+  struct InsertAction : juce::UndoableAction {
+    InsertAction(NoteGridComponent &grid, NoteStore notes) : m_grid(grid), m_added(std::move(notes)) {}
+
+    bool perform() override {
+      m_grid.m_notes.append(m_added);
+      m_grid.notesEdited();
+      return true;
+    }
+
+    bool undo() override {
+      m_grid.m_notes.resize(m_grid.m_notes.size() - m_added.size());
+      m_grid.notesEdited();
+      return true;
+    }
+
+    int getSizeInUnits() override {
+      return static_cast<int>(m_added.size()) + 1;
+    }
+
+    NoteGridComponent &m_grid;
+    NoteStore m_added;
+  };
+
+  // removes the notes at sorted indices
+  struct EraseAction : juce::UndoableAction {
+    EraseAction(NoteGridComponent &grid, std::vector<std::uint32_t> indices)
+      : m_grid(grid), m_indices(std::move(indices)) {}
+
+    bool perform() override {
+      m_removed = m_grid.m_notes.gather(m_indices);
+      m_grid.m_notes.erase(m_indices);
+      m_grid.notesEdited();
+      return true;
+    }
+
+    bool undo() override {
+      m_grid.m_notes.insert(m_indices, m_removed);
+      m_grid.notesEdited();
+      return true;
+    }
+
+    int getSizeInUnits() override {
+      return static_cast<int>(m_indices.size()) * 2 + 1;
+    }
+
+    NoteGridComponent &m_grid;
+    std::vector<std::uint32_t> m_indices;
+    NoteStore m_removed;
+  };
+
+  void notesEdited() {
+    // adding or removing notes moves the indices, the selection starts over
+    if (m_selected.size() != m_notes.size()) {
+      m_selected.assign(m_notes.size(), 0);
+      m_selection.clear();
+      noteMultiSelectionOn = false;
+    }
+    rebuildIndex();
+    repaint();
+    notesChanged();
+  }
+
+  NoteStore m_notes;
+  std::vector<juce::uint8> m_selected;
+  std::vector<size_t> m_selection;
+  NoteIndex m_index;
+  // reused by paint
+  std::vector<std::pair<size_t, juce::Rectangle<int>>> m_visible;
+
+  Drag m_drag{Drag::none};
+  size_t m_dragNote{0};
+  juce::Point<int> m_dragOffset{};
+  juce::Rectangle<int> m_resizeBounds{};
+
+  // sized in notes, keeping at least 30 steps
+  juce::UndoManager m_undo{1000000, 30};
+  juce::Random m_random;
+
   float scaledWidth{1.0f};
   float scaledHeight{1.0f};
+  TileCache m_background{[this](juce::Graphics &g, const juce::Rectangle<int> &area) { paintBackground(g, area); }};
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NoteGridComponent)
-};
+};
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "NoteStore.h"
+
+// Answers "which notes touch this range of lanes and units" without looking at the others.
+//
+// Each lane keeps its notes sorted by start, along with the length of its longest note. A note
+// overlapping [begin, end) starts before end and at most that length before begin, so a query is a
+// binary search per lane followed by a walk over the candidates. Built from scratch after an edit.
+struct NoteIndex {
+  static constexpr int Lanes = 128;
+
+  void rebuild(const NoteStore &notes) {
+    for (auto &lane: m_lanes) {
+      lane.entries.clear();
+      lane.longest = 0;
+    }
+    m_end = 0;
+    for (size_t i = 0; i < notes.size(); ++i) {
+      auto l = notes.lanes[i];
+      if (l < 0 || l >= Lanes) continue;
+      auto &lane = m_lanes[static_cast<size_t>(l)];
+      lane.entries.push_back({notes.starts[i], notes.ends[i], i});
+      lane.longest = std::max(lane.longest, notes.ends[i] - notes.starts[i]);
+      m_end = std::max(m_end, notes.ends[i]);
+    }
+    for (auto &lane: m_lanes) {
+      std::sort(std::begin(lane.entries), std::end(lane.entries), [](const Entry &a, const Entry &b) {
+        return a.start < b.start || (a.start == b.start && a.index < b.index);
+      });
+    }
+  }
+
+  // where the last note ends, 0 without notes
+  [[nodiscard]] int end() const {
+    return m_end;
+  }
+
+  // calls f(index) for every note in lanes [laneBegin, laneEnd) that overlaps units [begin, end),
+  // lane by lane and in start order within a lane
+  template<typename F>
+  void query(int laneBegin, int laneEnd, int begin, int end, F &&f) const {
+    laneBegin = std::max(0, laneBegin);
+    laneEnd = std::min(Lanes, laneEnd);
+    for (auto l = laneBegin; l < laneEnd; ++l) {
+      auto const &lane = m_lanes[static_cast<size_t>(l)];
+      auto from = begin - lane.longest;
+      auto itr = std::lower_bound(std::begin(lane.entries), std::end(lane.entries), from, [](const Entry &e, int start) {
+        return e.start < start;
+      });
+      for (; itr != std::end(lane.entries) && itr->start < end; ++itr) {
+        if (itr->end > begin) f(itr->index);
+      }
+    }
+  }
+
+private:
+  struct Entry {
+    int start;
+    int end;
+    size_t index;
+  };
+
+  struct Lane {
+    std::vector<Entry> entries;
+    int longest{0};
+  };
+
+  std::array<Lane, Lanes> m_lanes;
+  int m_end{0};
+};
@@ -1,10 +1,9 @@
 #pragma once
 
+// start and end are in grid units (Measure::unitsPerQuarter per quarter note), lane 0 is note 127
 struct NoteModel {
   int lane{0};
   int start{0};
   int end{0};
   float velocity{0.5f};
-  float scaledWidth{1.0f};
-  float scaledHeight{1.0f};
 };
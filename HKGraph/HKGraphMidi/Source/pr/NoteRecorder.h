@@ -0,0 +1,128 @@
+#pragma once
+
+#include "../Processors.h"
+#include "../RawMidi.h"
+#include "NoteModel.h"
+#include "Measure.h"
+
+// Records the notes going into a piano roll while the host transport plays.
+//
+// The audio thread only stamps each note-on and note-off with its song position and pushes it on a
+// preallocated single producer, single consumer queue; a full queue drops events instead of
+// waiting. The message thread drains the queue in batches, pairs note-ons with their note-offs and
+// snaps the finished notes to the grid.
+//
+// record may be called several times in one host block, once for every path that reaches the piano
+// roll. Each path's notes are recorded, but a pitch's note-on and its note-off are each taken once
+// per block, so a note arriving by two paths is not recorded twice.
+struct NoteRecorder {
+  static constexpr int Capacity = 4096;
+
+  struct Event {
+    double ppq;
+    juce::uint8 note;
+    // 0 for a note-off
+    juce::uint8 velocity;
+  };
+
+  // message thread
+  void setArmed(bool shouldRecord) {
+    m_armed.store(shouldRecord, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] bool isArmed() const {
+    return m_armed.load(std::memory_order_relaxed);
+  }
+
+  // audio thread. Note-offs are queued even when not armed, so a note held while recording stops
+  // still gets its end. Walks the events in place, nothing is decoded or allocated.
+  void record(const EventBuffer &events, const Transport &transport, int numSamples) {
+    if (transport.block != m_block) {
+      m_block = transport.block;
+      m_seenOn.fill(0);
+      m_seenOff.fill(0);
+    }
+    auto const &position = transport.position;
+    auto ppq = position.getPpqPosition();
+    auto bpm = position.getBpm();
+    if (!position.getIsPlaying() || !ppq || !bpm || transport.sampleRate <= 0.0) return;
+    auto armed = isArmed();
+    auto ppqPerSample = *bpm / 60.0 / transport.sampleRate;
+    auto loop = position.getLoopPoints();
+    auto looping = position.getIsLooping() && loop && loop->ppqEnd > loop->ppqStart && *ppq < loop->ppqEnd;
+    for (auto m: events) {
+      auto on = RawMidi::isNoteOn(m.data, m.numBytes);
+      if (!(on && armed) && !RawMidi::isNoteOff(m.data, m.numBytes)) continue;
+      auto note = static_cast<juce::uint8>(m.data[1] & 0x7F);
+      if (!firstInBlock(on ? m_seenOn : m_seenOff, note)) continue;
+      auto at = *ppq + juce::jlimit(0, numSamples, m.samplePosition) * ppqPerSample;
+      if (looping && at >= loop->ppqEnd) {
+        at -= loop->ppqEnd - loop->ppqStart;
+      }
+      push({at, note, on ? m.data[2] : juce::uint8{0}});
+    }
+  }
+
+  // message thread, drains the queue and returns the notes that were finished since the last call,
+  // snapped to unitsPerQuantize
+  std::vector<NoteModel> collect(int unitsPerQuantize) {
+    std::vector<NoteModel> finished;
+    auto scope = m_fifo.read(m_fifo.getNumReady());
+    auto take = [&](const Event &e) {
+      auto &held = m_held[e.note];
+      if (e.velocity > 0) {
+        // a note-on while the note is held means its note-off was never seen, start over
+        held = e;
+      } else if (held.has_value()) {
+        finished.push_back(toNote(*held, e.ppq, unitsPerQuantize));
+        held.reset();
+      }
+    };
+    for (auto i{0}; i < scope.blockSize1; ++i) take(m_events[static_cast<size_t>(scope.startIndex1 + i)]);
+    for (auto i{0}; i < scope.blockSize2; ++i) take(m_events[static_cast<size_t>(scope.startIndex2 + i)]);
+    return finished;
+  }
+
+private:
+  using NoteBits = std::array<std::uint64_t, 2>;
+
+  // marks the note as seen in this block, returns false if it already was
+  static bool firstInBlock(NoteBits &seen, int note) {
+    auto &word = seen[static_cast<size_t>(note / 64)];
+    auto mask = std::uint64_t{1} << (note % 64);
+    if (word & mask) return false;
+    word |= mask;
+    return true;
+  }
+
+  void push(const Event &event) {
+    auto scope = m_fifo.write(1);
+    if (scope.blockSize1 > 0) {
+      m_events[static_cast<size_t>(scope.startIndex1)] = event;
+    }
+  }
+
+  static NoteModel toNote(const Event &on, double endPpq, int unitsPerQuantize) {
+    auto grid = std::max(1, unitsPerQuantize);
+    auto snap = [grid](double ppq) {
+      return juce::roundToInt(ppq * Measure::unitsPerQuarter / grid) * grid;
+    };
+    NoteModel n;
+    n.lane = 127 - on.note;
+    n.start = std::max(0, snap(on.ppq));
+    // a note shorter than the grid still takes one step
+    n.end = std::max(n.start + grid, snap(endPpq));
+    n.velocity = static_cast<float>(on.velocity) / 127.0f;
+    return n;
+  }
+
+  std::atomic<bool> m_armed{false};
+  juce::AbstractFifo m_fifo{Capacity};
+  std::array<Event, Capacity> m_events{};
+  // audio thread, the notes already recorded in the current block
+  std::uint64_t m_block{~std::uint64_t{0}};
+  NoteBits m_seenOn{};
+  NoteBits m_seenOff{};
+  // message thread
+  std::array<std::optional<Event>, 128> m_held{};
+};
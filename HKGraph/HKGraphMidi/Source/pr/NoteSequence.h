@@ -0,0 +1,79 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "NoteModel.h"
+#include "Measure.h"
+
+// The note-ons and note-offs of a piano roll in time order, built on the message thread from the
+// notes being edited and handed to the audio thread as a whole (see RcuPointer). Positions are in
+// quarter notes, the unit juce::AudioPlayHead reports the song position in.
+struct NoteSequence {
+  struct Event {
+    double ppq;
+    juce::uint8 note;
+    // 0 for a note-off
+    juce::uint8 velocity;
+  };
+
+  using NoteBits = std::array<std::uint64_t, 2>;
+  // the notes sounding before every CheckpointInterval-th event, see soundingAt()
+  static constexpr size_t CheckpointInterval = 64;
+
+  // tells one build from another, addresses can be reused
+  std::uint64_t version{0};
+  std::vector<Event> events;
+  std::vector<NoteBits> checkpoints;
+
+  static std::unique_ptr<NoteSequence> build(const std::vector<NoteModel> &notes, std::uint64_t version) {
+    auto sequence = std::make_unique<NoteSequence>();
+    sequence->version = version;
+    sequence->events.reserve(notes.size() * 2);
+    for (auto const &n: notes) {
+      if (n.end <= n.start) continue;
+      auto note = static_cast<juce::uint8>(juce::jlimit(0, 127, 127 - n.lane));
+      auto velocity = static_cast<juce::uint8>(juce::jlimit(1, 127, juce::roundToInt(n.velocity * 127.0f)));
+      sequence->events.push_back({toPpq(n.start), note, velocity});
+      sequence->events.push_back({toPpq(n.end), note, 0});
+    }
+    // note-offs go first, so a note that starts where another one ends is struck again
+    std::sort(std::begin(sequence->events), std::end(sequence->events), [](const Event &a, const Event &b) {
+      return a.ppq < b.ppq || (a.ppq == b.ppq && a.velocity < b.velocity);
+    });
+    NoteBits sounding{};
+    sequence->checkpoints.reserve(sequence->events.size() / CheckpointInterval + 1);
+    for (size_t i = 0; i < sequence->events.size(); ++i) {
+      if (i % CheckpointInterval == 0) sequence->checkpoints.push_back(sounding);
+      apply(sequence->events[i], sounding);
+    }
+    return sequence;
+  }
+
+  // the notes sounding just before events[index], replays at most CheckpointInterval events
+  [[nodiscard]] NoteBits soundingAt(size_t index) const {
+    if (checkpoints.empty()) return {};
+    auto checkpoint = std::min(index / CheckpointInterval, checkpoints.size() - 1);
+    auto sounding = checkpoints[checkpoint];
+    for (auto i = checkpoint * CheckpointInterval; i < index && i < events.size(); ++i) {
+      apply(events[i], sounding);
+    }
+    return sounding;
+  }
+
+  // index of the first event at or after ppq
+  [[nodiscard]] size_t seek(double ppq) const {
+    auto itr = std::lower_bound(std::begin(events), std::end(events), ppq, [](const Event &e, double p) {
+      return e.ppq < p;
+    });
+    return static_cast<size_t>(std::distance(std::begin(events), itr));
+  }
+
+  static void apply(const Event &e, NoteBits &sounding) {
+    auto bit = std::uint64_t{1} << (e.note % 64);
+    auto &word = sounding[e.note / 64];
+    word = e.velocity > 0 ? (word | bit) : (word & ~bit);
+  }
+
+  static double toPpq(int units) {
+    return static_cast<double>(units) / static_cast<double>(Measure::unitsPerQuarter);
+  }
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "NoteModel.h"
+
+// The notes of a piano roll, one array per field: note i is lanes[i], starts[i], ends[i] and
+// velocities[i]. An edit over many notes is then a plain loop over the fields it touches.
+struct NoteStore {
+  std::vector<int> lanes;
+  std::vector<int> starts;
+  std::vector<int> ends;
+  std::vector<float> velocities;
+
+  static NoteStore of(const std::vector<NoteModel> &models) {
+    NoteStore store;
+    store.reserve(models.size());
+    for (auto const &n: models) {
+      store.append(n);
+    }
+    return store;
+  }
+
+  [[nodiscard]] size_t size() const {
+    return starts.size();
+  }
+
+  [[nodiscard]] bool empty() const {
+    return starts.empty();
+  }
+
+  [[nodiscard]] NoteModel at(size_t i) const {
+    return {lanes[i], starts[i], ends[i], velocities[i]};
+  }
+
+  void set(size_t i, const NoteModel &n) {
+    lanes[i] = n.lane;
+    starts[i] = n.start;
+    ends[i] = n.end;
+    velocities[i] = n.velocity;
+  }
+
+  [[nodiscard]] std::vector<NoteModel> models() const {
+    std::vector<NoteModel> result;
+    result.reserve(size());
+    for (size_t i = 0; i < size(); ++i) {
+      result.push_back(at(i));
+    }
+    return result;
+  }
+
+  void reserve(size_t n) {
+    lanes.reserve(n);
+    starts.reserve(n);
+    ends.reserve(n);
+    velocities.reserve(n);
+  }
+
+  void resize(size_t n) {
+    lanes.resize(n);
+    starts.resize(n);
+    ends.resize(n);
+    velocities.resize(n);
+  }
+
+  void clear() {
+    resize(0);
+  }
+
+  void append(const NoteModel &n) {
+    lanes.push_back(n.lane);
+    starts.push_back(n.start);
+    ends.push_back(n.end);
+    velocities.push_back(n.velocity);
+  }
+
+  void append(const NoteStore &other) {
+    lanes.insert(std::end(lanes), std::begin(other.lanes), std::end(other.lanes));
+    starts.insert(std::end(starts), std::begin(other.starts), std::end(other.starts));
+    ends.insert(std::end(ends), std::begin(other.ends), std::end(other.ends));
+    velocities.insert(std::end(velocities), std::begin(other.velocities), std::end(other.velocities));
+  }
+
+  // the notes at indices, in that order
+  [[nodiscard]] NoteStore gather(const std::vector<std::uint32_t> &indices) const {
+    NoteStore result;
+    result.resize(indices.size());
+    for (size_t k = 0; k < indices.size(); ++k) result.lanes[k] = lanes[indices[k]];
+    for (size_t k = 0; k < indices.size(); ++k) result.starts[k] = starts[indices[k]];
+    for (size_t k = 0; k < indices.size(); ++k) result.ends[k] = ends[indices[k]];
+    for (size_t k = 0; k < indices.size(); ++k) result.velocities[k] = velocities[indices[k]];
+    return result;
+  }
+
+  // the reverse of gather, values[k] goes to indices[k]
+  void scatter(const std::vector<std::uint32_t> &indices, const NoteStore &values) {
+    for (size_t k = 0; k < indices.size(); ++k) lanes[indices[k]] = values.lanes[k];
+    for (size_t k = 0; k < indices.size(); ++k) starts[indices[k]] = values.starts[k];
+    for (size_t k = 0; k < indices.size(); ++k) ends[indices[k]] = values.ends[k];
+    for (size_t k = 0; k < indices.size(); ++k) velocities[indices[k]] = values.velocities[k];
+  }
+
+  // removes the notes at indices, which are sorted, keeping the others in order
+  void erase(const std::vector<std::uint32_t> &indices) {
+    eraseFrom(lanes, indices);
+    eraseFrom(starts, indices);
+    eraseFrom(ends, indices);
+    eraseFrom(velocities, indices);
+  }
+
+  // the reverse of erase: puts values[k] back at indices[k], which are sorted
+  void insert(const std::vector<std::uint32_t> &indices, const NoteStore &values) {
+    insertInto(lanes, indices, values.lanes);
+    insertInto(starts, indices, values.starts);
+    insertInto(ends, indices, values.ends);
+    insertInto(velocities, indices, values.velocities);
+  }
+
+private:
+  template<typename T>
+  static void eraseFrom(std::vector<T> &column, const std::vector<std::uint32_t> &indices) {
+    size_t out = 0;
+    size_t k = 0;
+    for (size_t i = 0; i < column.size(); ++i) {
+      if (k < indices.size() && indices[k] == i) {
+        ++k;
+        continue;
+      }
+      column[out++] = column[i];
+    }
+    column.resize(out);
+  }
+
+  template<typename T>
+  static void insertInto(std::vector<T> &column, const std::vector<std::uint32_t> &indices, const std::vector<T> &values) {
+    std::vector<T> result(column.size() + indices.size());
+    size_t from = 0;
+    size_t k = 0;
+    for (size_t i = 0; i < result.size(); ++i) {
+      result[i] = k < indices.size() && indices[k] == i ? values[k++] : column[from++];
+    }
+    column = std::move(result);
+  }
+};
@@ -4,7 +4,6 @@
 #include "SelectionComponent.h"
 #include "SyncViewPort.h"
 #include "PianoRollTheme.h"
-#include "NoteComponent.h"
 #include "NoteGridComponent.h"
 #include "TimelineComponent.h"
 #include "KeysComponent.h"
@@ -13,8 +12,12 @@ struct PianoRollComponent : juce::Component {
 
   static constexpr auto laneHeight = 7;
   static constexpr auto unit = 2;
-  static constexpr auto bars = 32;
   static constexpr auto nKeys = 128;
+  // the song is never shorter than this
+  static constexpr auto minimumBars = 32;
+  // room left after the last note, and added when scrolling close to the end
+  static constexpr auto headroomBars = 8;
+  int bars{minimumBars};
   int quantize{1};
 
   juce::AudioPlayHead::TimeSignature timeSignature{4, 4};
@@ -47,6 +50,10 @@ struct PianoRollComponent : juce::Component {
     noteGridViewPort.callback = [this](auto *vp, auto &r) -> void {
       return onScroll(vp, r);
     };
+    noteGrid.onExtentChanged = [this](int end) {
+      notesEnd = end;
+      updateLength(true);
+    };
   }
 
   ~PianoRollComponent() override = default;
@@ -110,10 +117,11 @@ struct PianoRollComponent : juce::Component {
   void setTimeSignature(int numerator, int denominator) {
     timeSignature.numerator = numerator;
     timeSignature.denominator = denominator;
-    noteGrid.timeSignature.numerator = numerator;
-    noteGrid.timeSignature.denominator = denominator;
-    timeline.timeSignature.numerator = numerator;
-    timeline.timeSignature.denominator = denominator;
+    noteGrid.setTimeSignature(numerator, denominator);
+    timeline.setTimeSignature(numerator, denominator);
+    // the bar width changed, the length in bars follows the notes and the view
+    updateLength(true);
+    resizeTimeline();
   }
 
   void onScroll(SyncViewport *vp, const juce::Rectangle<int> &) {
@@ -121,13 +129,31 @@ struct PianoRollComponent : juce::Component {
     timelineViewPort.getHorizontalScrollBar().setCurrentRangeStart(horizontalRange);
     auto verticalRange = vp->getVerticalScrollBar().getCurrentRangeStart();
     keyboardViewPort.getVerticalScrollBar().setCurrentRangeStart(verticalRange);
+    // scrolling towards the end makes the song longer, so there is always somewhere to go
+    updateLength(false);
+  }
+
+  // fits the length to the notes and to what is in view, only growing unless shrink is set
+  void updateLength(bool shrink) {
+    auto barWidth = Measure::barWidth(timeSignature, unit);
+    auto unitsPerBar = Measure::unitsPerBar(timeSignature);
+    auto visible = noteGrid.getLocalArea(&noteGridViewPort, noteGridViewPort.getLocalBounds());
+    auto visibleEnd = (visible.getRight() + barWidth - 1) / barWidth;
+    auto required = (notesEnd + unitsPerBar - 1) / unitsPerBar;
+    // close to the end of the view, add headroom so the next scroll has somewhere to go
+    auto nearEnd = visible.getRight() > (bars - headroomBars / 2) * barWidth;
+    auto length = std::max({minimumBars, required + headroomBars, nearEnd ? visibleEnd + headroomBars : visibleEnd});
+    if (length == bars || (length < bars && !shrink)) return;
+    bars = length;
+    noteGrid.setBars(bars);
+    timeline.setBars(bars);
+    resizeTimeline();
   }
 
   void onTimelineMouseDown(const juce::MouseEvent &e) {
     auto x = e.getPosition().toFloat().x;
-    timeline.playHeadPosition = x;
-    noteGrid.playHeadPosition = x;
-    repaint();
+    timeline.setPlayHeadPosition(x);
+    noteGrid.setPlayHeadPosition(x);
   }
 
   [[nodiscard]] int getQuantize() const {
@@ -136,12 +162,19 @@ struct PianoRollComponent : juce::Component {
 
   void setQuantize(int v) {
     quantize = v;
-    noteGrid.quantize = v;
-    timeline.quantize = v;
-    repaint();
+    noteGrid.setQuantize(v);
+    timeline.setQuantize(v);
   }
 
 private:
+  void resizeTimeline() {
+    // to compensate for the visible scrollbar in the grid, since the timeline scrollbars are not visible
+    auto scrollbarWidth = juce::LookAndFeel::getDefaultLookAndFeel().getDefaultScrollbarWidth();
+    timeline.setSize(noteGrid.getWidth() + scrollbarWidth, timeline.getHeight());
+  }
+
+  // where the last note ends, in units
+  int notesEnd{0};
   float scaledWidth{1.0f};
   float scaledHeight{1.0f};
 
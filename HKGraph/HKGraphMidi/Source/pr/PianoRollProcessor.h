@@ -3,27 +3,86 @@
 #include "../Processors.h"
 #include "NodeProcessor.h"
 #include "../RangeParameter.h"
+#include "../RcuPointer.h"
 #include "ConstrainedComponent.h"
+#include "TelemetrySlot.h"
 #include "PianoRollComponent.h"
+#include "NoteSequence.h"
+#include "SequencePlayer.h"
+#include "NoteRecorder.h"
 
-struct PianoRollProcessor : public NodeProcessor {
+struct PianoRollProcessor : public NodeProcessor, private TelemetryPoller::Client {
 
   static constexpr int MIN_WIDTH = 600;
   static constexpr int MIN_HEIGHT = 600;
 
+  // called on the message thread with each batch of recorded notes, after they were added
+  std::function<void(const std::vector<NoteModel> &)> onRecorded;
+
   explicit PianoRollProcessor(Graph *graph) :
     NodeProcessor(graph) {
+    m_poller->add(this);
   }
 
   PianoRollProcessor(Graph *graph, const std::string &name, uint32_t n_ins, uint32_t n_outs)
     : NodeProcessor(graph, name, n_ins, n_outs) {
+    m_poller->add(this);
   }
 
-  ~PianoRollProcessor() override = default;
+  ~PianoRollProcessor() override {
+    m_poller->remove(this);
+  }
 
+  // plays the notes along the host transport, mixed into whatever comes in
   void
   on_data(Graph *graph, const std::optional<const Graph::Node::Pin> &pin, Data &data) override {
-    juce::ignoreUnused(graph, pin, data);
+    juce::ignoreUnused(pin);
+    auto input = std::any_cast<Block>(data);
+    // what comes in is recorded before the notes played here are mixed in
+    if (input.transport != nullptr) {
+      m_recorder.record(input.events, *input.transport, input.audioBuffer.getNumSamples());
+    }
+    // once per host block, however many times the node is reached
+    if (input.transport != nullptr && m_blocks.first(input)) {
+      RcuPointer<NoteSequence>::Reader sequence(m_sequence);
+      m_player.process(sequence.get(), *input.transport, input.audioBuffer.getNumSamples(), input.events);
+    }
+    Data result = std::make_any<Block>(std::move(input));
+    for (auto &[_, p]: m_outs) {
+      p.async_dispatch(graph, result);
+    }
+  }
+
+  // message thread
+  [[nodiscard]] const std::vector<NoteModel> &notes() const {
+    return m_notes;
+  }
+
+  // message thread, the audio thread picks the new notes up on its next block
+  void setNotes(std::vector<NoteModel> notes) {
+    auto same = [](const NoteModel &a, const NoteModel &b) {
+      return a.lane == b.lane && a.start == b.start && a.end == b.end && a.velocity == b.velocity;
+    };
+    // a click that moved nothing keeps the published sequence
+    if (std::equal(std::begin(notes), std::end(notes), std::begin(m_notes), std::end(m_notes), same)) {
+      return;
+    }
+    m_notes = std::move(notes);
+    m_sequence.publish(NoteSequence::build(m_notes, ++m_version));
+  }
+
+  // message thread
+  void setRecording(bool shouldRecord) {
+    m_recorder.setArmed(shouldRecord);
+  }
+
+  [[nodiscard]] bool isRecording() const {
+    return m_recorder.isArmed();
+  }
+
+  // message thread, the grid recorded notes snap to
+  void setQuantize(const juce::AudioPlayHead::TimeSignature &timeSignature, int quantize) {
+    m_unitsPerQuantize = Measure::unitsPerQuantize(timeSignature, quantize);
   }
 
   [[nodiscard]] std::string typeId() const override {
@@ -31,11 +90,29 @@ struct PianoRollProcessor : public NodeProcessor {
   }
 
   void saveState(juce::ValueTree &nodeTree) override {
-    juce::ignoreUnused(nodeTree);
+    juce::ValueTree notesTree{"PianoRollProcessor::notes"};
+    for (auto const &n: m_notes) {
+      juce::ValueTree noteTree{"note"};
+      noteTree.setProperty("lane", juce::var(n.lane), nullptr);
+      noteTree.setProperty("start", juce::var(n.start), nullptr);
+      noteTree.setProperty("end", juce::var(n.end), nullptr);
+      noteTree.setProperty("velocity", juce::var(n.velocity), nullptr);
+      notesTree.appendChild(noteTree, nullptr);
+    }
+    nodeTree.appendChild(notesTree, nullptr);
   }
 
   void restoreState(const juce::ValueTree &nodeTree) override {
-    juce::ignoreUnused(nodeTree);
+    std::vector<NoteModel> notes;
+    for (auto const &noteTree: nodeTree.getChildWithName("PianoRollProcessor::notes")) {
+      NoteModel n;
+      n.lane = noteTree.getProperty("lane");
+      n.start = noteTree.getProperty("start");
+      n.end = noteTree.getProperty("end");
+      n.velocity = noteTree.getProperty("velocity");
+      notes.push_back(n);
+    }
+    setNotes(std::move(notes));
   }
 
   NodeProcessor *clone() override {
@@ -46,6 +123,7 @@ struct PianoRollProcessor : public NodeProcessor {
         static_cast<std::uint32_t>(m_ins.size()),
         static_cast<std::uint32_t>(m_outs.size()));
     c->m_muted = m_muted;
+    c->setNotes(m_notes);
     return c;
   }
 
@@ -64,6 +142,8 @@ struct PianoRollProcessor : public NodeProcessor {
 
     juce::Label labelTimeSignature{};
 
+    juce::TextButton buttonRecord{"rec"};
+
     Panel(PianoRollProcessor *p, const GraphViewTheme &viewTheme)
       : ConstrainedComponent(),
         processor(p),
@@ -75,6 +155,13 @@ struct PianoRollProcessor : public NodeProcessor {
         sliderTimeSignatureDenominator(juce::Slider::LinearBar, juce::Slider::NoTextBox) {
       m_constrains.setMinimumSize(200, 200);
 
+      pianoRoll.noteGrid.setNotes(processor->notes());
+      pianoRoll.noteGrid.onNotesChanged = [this]() {
+        processor->setNotes(pianoRoll.noteGrid.models());
+      };
+      processor->onRecorded = [this](const std::vector<NoteModel> &recorded) {
+        pianoRoll.noteGrid.addNotes(recorded);
+      };
       addAndMakeVisible(pianoRoll);
 
       sliderNoteGridLaneHeight.setRange(1.0f, 4.0f, 0.1f);
@@ -102,6 +189,7 @@ struct PianoRollProcessor : public NodeProcessor {
         auto v = static_cast<int>(sliderNoteGridQuantize.getValue());
         auto q = static_cast<int>(std::pow(2, v));
         pianoRoll.setQuantize(q);
+        processor->setQuantize(pianoRoll.timeSignature, q);
         pianoRoll.repaint();
       };
       addAndMakeVisible(sliderNoteGridQuantize);
@@ -112,6 +200,7 @@ struct PianoRollProcessor : public NodeProcessor {
         auto d = static_cast<int>(sliderTimeSignatureDenominator.getValue());
         d = static_cast<int>(std::pow(2, d));
         pianoRoll.setTimeSignature(n, d);
+        processor->setQuantize(pianoRoll.timeSignature, pianoRoll.getQuantize());
         labelTimeSignature.setText(juce::String(n) + "/" + juce::String(d), juce::NotificationType::dontSendNotification);
         pianoRoll.repaint();
       };
@@ -128,9 +217,18 @@ struct PianoRollProcessor : public NodeProcessor {
       addAndMakeVisible(sliderTimeSignatureDenominator);
 
       addAndMakeVisible(labelTimeSignature);
+
+      buttonRecord.setClickingTogglesState(true);
+      buttonRecord.setToggleState(processor->isRecording(), juce::dontSendNotification);
+      buttonRecord.onClick = [this]() {
+        processor->setRecording(buttonRecord.getToggleState());
+      };
+      addAndMakeVisible(buttonRecord);
     }
 
-    ~Panel() override = default;
+    ~Panel() override {
+      processor->onRecorded = nullptr;
+    }
 
     void paint(juce::Graphics &g) override {
       g.fillAll(juce::Colour(theme.cNodeBackground));
@@ -218,6 +316,15 @@ struct PianoRollProcessor : public NodeProcessor {
           .withMaxWidth(40.0f)
           .withFlex(0.2f)
           .withMargin(margin));
+      controls.items.add(
+        juce::FlexItem(buttonRecord)
+          .withAlignSelf(juce::FlexItem::AlignSelf::flexEnd)
+          .withMinHeight(10.0f)
+          .withMaxHeight(10.0f)
+          .withMinWidth(40.0f)
+          .withMaxWidth(40.0f)
+          .withFlex(0.2f)
+          .withMargin(margin));
 
 
 
@@ -233,4 +340,26 @@ struct PianoRollProcessor : public NodeProcessor {
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Panel)
   };
 
-};
+private:
+  // merges whatever was recorded since the last poll
+  void poll() override {
+    auto recorded = m_recorder.collect(m_unitsPerQuantize);
+    if (recorded.empty()) return;
+    auto notes = m_notes;
+    notes.insert(std::end(notes), std::begin(recorded), std::end(recorded));
+    setNotes(std::move(notes));
+    if (onRecorded != nullptr) {
+      onRecorded(recorded);
+    }
+  }
+
+  std::vector<NoteModel> m_notes;
+  std::uint64_t m_version{0};
+  RcuPointer<NoteSequence> m_sequence;
+  NoteRecorder m_recorder;
+  int m_unitsPerQuantize{Measure::unitsPerQuarter};
+  juce::SharedResourcePointer<TelemetryPoller> m_poller;
+  // audio thread
+  SequencePlayer m_player;
+  OncePerBlock m_blocks;
+};
\ No newline at end of file
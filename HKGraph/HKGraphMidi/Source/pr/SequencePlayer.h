@@ -0,0 +1,130 @@
+#pragma once
+
+#include "../Processors.h"
+#include "NoteSequence.h"
+
+// Follows the host transport through a NoteSequence, one block at a time, on the audio thread.
+//
+// While the transport runs on, each block picks up where the previous one stopped, so the cost is
+// the events it emits. Anything else (start, seek, a loop wrapped by the host) releases what is
+// sounding and finds the new position by binary search. A new sequence is picked up at the same
+// position, releasing only the notes it no longer holds. The tempo is read every block, so tempo
+// changes move the next block's events without a jump.
+struct SequencePlayer {
+  static constexpr int channel = 1;
+
+  // adds the sequence's events for this block to output, sequence may be null
+  void process(const NoteSequence *sequence, const Transport &transport, int numSamples, EventBuffer &output) {
+    auto const &position = transport.position;
+    auto ppq = position.getPpqPosition();
+    auto bpm = position.getBpm();
+    if (sequence == nullptr || !position.getIsPlaying() || !ppq || !bpm || *bpm <= 0.0 ||
+        transport.sampleRate <= 0.0 || numSamples <= 0) {
+      stop(output);
+      return;
+    }
+
+    m_ppqPerSample = *bpm / 60.0 / transport.sampleRate;
+    auto start = *ppq;
+    auto end = start + numSamples * m_ppqPerSample;
+    // hosts round positions and apply tempo changes mid-block, drift within a block is not a jump
+    auto drift = start - m_next;
+    auto jumped = drift < -(end - start) || drift > end - start;
+    if (!m_playing || jumped) {
+      releaseAll(output, 0);
+      m_playing = true;
+      m_version = sequence->version;
+      m_cursor = sequence->seek(start);
+    } else if (sequence->version != m_version) {
+      m_version = sequence->version;
+      m_cursor = sequence->seek(m_next);
+      releaseRemoved(sequence->soundingAt(m_cursor), output);
+    }
+
+    auto loop = position.getLoopPoints();
+    if (position.getIsLooping() && loop && loop->ppqEnd > loop->ppqStart && start < loop->ppqEnd && end > loop->ppqEnd) {
+      // the loop wraps inside this block
+      auto wrap = juce::jlimit(0, numSamples - 1, static_cast<int>((loop->ppqEnd - start) / m_ppqPerSample));
+      play(*sequence, start, loop->ppqEnd, 0, numSamples, output);
+      releaseAll(output, wrap);
+      m_cursor = sequence->seek(loop->ppqStart);
+      auto remaining = end - loop->ppqEnd;
+      play(*sequence, loop->ppqStart, loop->ppqStart + remaining, wrap, numSamples, output);
+      m_next = loop->ppqStart + remaining;
+    } else {
+      play(*sequence, start, end, 0, numSamples, output);
+      m_next = end;
+    }
+  }
+
+  // the transport stopped, or there is nothing to play
+  void stop(EventBuffer &output) {
+    if (m_playing) {
+      releaseAll(output, 0);
+      m_playing = false;
+    }
+  }
+
+  void releaseAll(EventBuffer &output, int samplePosition) {
+    if (m_numSounding == 0) return;
+    for (auto note{0}; note < 128; ++note) {
+      if (m_sounding[static_cast<size_t>(note)] > 0) {
+        output.addEvent(juce::MidiMessage::noteOff(channel, note), samplePosition);
+        m_sounding[static_cast<size_t>(note)] = 0;
+      }
+    }
+    m_numSounding = 0;
+  }
+
+private:
+  // after an edit: notes that no longer span the current position would never get their note-off
+  void releaseRemoved(const NoteSequence::NoteBits &kept, EventBuffer &output) {
+    if (m_numSounding == 0) return;
+    for (auto note{0}; note < 128; ++note) {
+      auto &count = m_sounding[static_cast<size_t>(note)];
+      if (count == 0) continue;
+      if ((kept[static_cast<size_t>(note / 64)] >> (note % 64)) & 1) {
+        // whichever of the overlapping notes is left ends it now
+        count = 1;
+      } else {
+        output.addEvent(juce::MidiMessage::noteOff(channel, note), 0);
+        count = 0;
+        --m_numSounding;
+      }
+    }
+  }
+
+  // emits the events in [from, to), the first one at firstSample. Events the cursor passed over
+  // before from (the transport drifted ahead) are late and go out at firstSample.
+  void play(const NoteSequence &sequence, double from, double to, int firstSample, int numSamples, EventBuffer &output) {
+    auto const &events = sequence.events;
+    while (m_cursor < events.size() && events[m_cursor].ppq < to) {
+      auto const &e = events[m_cursor++];
+      auto offset = e.ppq > from ? static_cast<int>((e.ppq - from) / m_ppqPerSample) : 0;
+      auto samplePosition = juce::jlimit(0, numSamples - 1, firstSample + offset);
+      auto &count = m_sounding[e.note];
+      if (e.velocity > 0) {
+        // overlapping notes of the same pitch: strike it again, release it with the last note-off
+        if (count > 0) {
+          output.addEvent(juce::MidiMessage::noteOff(channel, e.note), samplePosition);
+        } else {
+          ++m_numSounding;
+        }
+        ++count;
+        output.addEvent(juce::MidiMessage::noteOn(channel, e.note, e.velocity), samplePosition);
+      } else if (count > 0 && --count == 0) {
+        --m_numSounding;
+        output.addEvent(juce::MidiMessage::noteOff(channel, e.note), samplePosition);
+      }
+    }
+  }
+
+  bool m_playing{false};
+  std::uint64_t m_version{0};
+  size_t m_cursor{0};
+  // where the next block starts if the transport runs on
+  double m_next{0.0};
+  double m_ppqPerSample{0.0};
+  std::array<juce::uint8, 128> m_sounding{};
+  int m_numSounding{0};
+};
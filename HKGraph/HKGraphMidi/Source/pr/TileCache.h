@@ -0,0 +1,106 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+// Keeps what a component draws under everything else as images, one per tile of the component.
+//
+// Tiles are laid out in component coordinates and rendered at the scale the component is shown
+// at, so blitting one is a plain copy. paint renders only the tiles under the clip region that are
+// not cached yet. The owner calls invalidate when what the tiles show changes, setScale does it
+// when the scale does. A tile cut by the edge of the component is rendered again once the
+// component is resized. Past MaxTiles, the tiles drawn least recently are dropped.
+struct TileCache {
+  // the size of a tile on screen
+  static constexpr int TilePixels = 256;
+  static constexpr size_t MaxTiles = 96;
+
+  // draws the given area, in component coordinates
+  using Render = std::function<void(juce::Graphics &, const juce::Rectangle<int> &)>;
+
+  explicit TileCache(Render render) : m_render(std::move(render)) {}
+
+  void invalidate() {
+    m_tiles.clear();
+  }
+
+  // drops the tiles reaching past x, in component coordinates, for content that changed there only
+  void invalidateFrom(int x) {
+    std::erase_if(m_tiles, [x](const auto &tile) {
+      return tile.second.area.getRight() > x;
+    });
+  }
+
+  void setScale(float widthFactor, float heightFactor) {
+    if (juce::approximatelyEqual(widthFactor, m_scaleX) && juce::approximatelyEqual(heightFactor, m_scaleY)) return;
+    m_scaleX = widthFactor;
+    m_scaleY = heightFactor;
+    m_tileWidth = std::max(16, juce::roundToInt(static_cast<float>(TilePixels) / widthFactor));
+    m_tileHeight = std::max(16, juce::roundToInt(static_cast<float>(TilePixels) / heightFactor));
+    invalidate();
+  }
+
+  // blits the tiles under the clip region, bounds are the component's local bounds
+  void paint(juce::Graphics &g, const juce::Rectangle<int> &bounds) {
+    auto clip = g.getClipBounds().getIntersection(bounds);
+    if (clip.isEmpty()) return;
+    ++m_frame;
+    for (auto row = clip.getY() / m_tileHeight; row <= (clip.getBottom() - 1) / m_tileHeight; ++row) {
+      for (auto column = clip.getX() / m_tileWidth; column <= (clip.getRight() - 1) / m_tileWidth; ++column) {
+        auto area = juce::Rectangle<int>(column * m_tileWidth, row * m_tileHeight, m_tileWidth, m_tileHeight)
+          .getIntersection(bounds);
+        g.drawImage(tile(column, row, area), area.toFloat());
+      }
+    }
+    evict();
+  }
+
+private:
+  struct Tile {
+    juce::Image image;
+    juce::Rectangle<int> area;
+    std::uint64_t lastDrawn;
+  };
+
+  const juce::Image &tile(int column, int row, const juce::Rectangle<int> &area) {
+    auto key = (static_cast<std::uint64_t>(static_cast<std::uint32_t>(column)) << 32) | static_cast<std::uint32_t>(row);
+    auto itr = m_tiles.find(key);
+    if (itr != std::end(m_tiles) && itr->second.area != area) {
+      m_tiles.erase(itr);
+      itr = std::end(m_tiles);
+    }
+    if (itr == std::end(m_tiles)) {
+      juce::Image image(
+        juce::Image::RGB,
+        std::max(1, static_cast<int>(std::ceil(static_cast<float>(area.getWidth()) * m_scaleX))),
+        std::max(1, static_cast<int>(std::ceil(static_cast<float>(area.getHeight()) * m_scaleY))),
+        true);
+      juce::Graphics ig(image);
+      ig.addTransform(
+        juce::AffineTransform::translation(static_cast<float>(-area.getX()), static_cast<float>(-area.getY()))
+          .scaled(m_scaleX, m_scaleY));
+      m_render(ig, area);
+      itr = m_tiles.emplace(key, Tile{image, area, 0}).first;
+    }
+    itr->second.lastDrawn = m_frame;
+    return itr->second.image;
+  }
+
+  void evict() {
+    while (m_tiles.size() > MaxTiles) {
+      auto oldest = std::min_element(std::begin(m_tiles), std::end(m_tiles), [](const auto &a, const auto &b) {
+        return a.second.lastDrawn < b.second.lastDrawn;
+      });
+      // never drop what was just drawn, a clip region larger than the cache keeps it all
+      if (oldest->second.lastDrawn == m_frame) return;
+      m_tiles.erase(oldest);
+    }
+  }
+
+  Render m_render;
+  std::unordered_map<std::uint64_t, Tile> m_tiles;
+  float m_scaleX{1.0f};
+  float m_scaleY{1.0f};
+  int m_tileWidth{TilePixels};
+  int m_tileHeight{TilePixels};
+  std::uint64_t m_frame{0};
+};
@@ -3,6 +3,7 @@
 #include "JuceHeader.h"
 #include "PianoRollTheme.h"
 #include "Measure.h"
+#include "TileCache.h"
 
 struct TimelineComponent : public juce::Component {
   juce::AudioPlayHead::TimeSignature timeSignature{};
@@ -27,6 +28,15 @@ struct TimelineComponent : public juce::Component {
   ~TimelineComponent() override = default;
 
   void paint(juce::Graphics &g) override {
+    m_background.paint(g, getLocalBounds());
+
+    // draw play head
+    g.setColour(juce::Colours::white);
+    g.fillRect(playHeadBounds());
+  }
+
+  // the bar and beat marks, cached in tiles
+  void paintBackground(juce::Graphics &g, const juce::Rectangle<int> &area) const {
     auto bounds = getLocalBounds();
     g.setColour(juce::Colour(0xff343d48));
     g.fillRect(bounds);
@@ -39,11 +49,15 @@ struct TimelineComponent : public juce::Component {
     g.setFont(f);
 
 
-    auto x = 0;
     auto unitsPerBar = Measure::unitsPerBar(timeSignature);
     auto unitsPerBeat = Measure::unitsPerBeat(timeSignature);
     auto unitsPerQuantize = Measure::unitsPerQuantize(timeSignature, quantize);
-    for (auto bar = 0; bar < bars; ++bar) {
+    // the bars in the area, and the one before it whose numbers may spill over
+    auto barWidth = Measure::barWidth(timeSignature, unit);
+    auto firstBar = std::max(0, area.getX() / barWidth - 1);
+    auto lastBar = std::min(bars, area.getRight() / barWidth + 1);
+    auto x = firstBar * barWidth;
+    for (auto bar = firstBar; bar < lastBar; ++bar) {
       auto beat = 0;
       // draw bar numbers
       g.saveState(); // we are about to set a transform
@@ -98,15 +112,6 @@ struct TimelineComponent : public juce::Component {
         x += unit;
       }
     }
-
-    // draw play head
-    g.setColour(juce::Colours::white);
-    g.fillRect(
-      playHeadPosition,
-      0.0f,
-      vBarSeparatorWidth,
-      static_cast<float>(bounds.getHeight())
-    );
   }
 
   void mouseDown(const juce::MouseEvent &e) override {
@@ -117,10 +122,46 @@ struct TimelineComponent : public juce::Component {
   void setScale(float widthFactor, float heightFactor) {
     scaledWidth = widthFactor;
     scaledHeight = heightFactor;
+    // the timeline is only ever stretched horizontally
+    m_background.setScale(widthFactor, 1.0f);
+    repaint();
+  }
+
+  void setTimeSignature(int numerator, int denominator) {
+    timeSignature.numerator = numerator;
+    timeSignature.denominator = denominator;
+    m_background.invalidate();
+    repaint();
+  }
+
+  void setBars(int numberOfBars) {
+    if (numberOfBars == bars) return;
+    // the timeline is wider than the grid, tiles past the old end were drawn without those bars
+    m_background.invalidateFrom(std::min(bars, numberOfBars) * Measure::barWidth(timeSignature, unit));
+    bars = numberOfBars;
+    repaint();
+  }
+
+  void setQuantize(int v) {
+    quantize = v;
+    m_background.invalidate();
+    repaint();
+  }
+
+  // only repaints the strips under the old and the new play head
+  void setPlayHeadPosition(float x) {
+    repaint(playHeadBounds().getSmallestIntegerContainer());
+    playHeadPosition = x;
+    repaint(playHeadBounds().getSmallestIntegerContainer());
   }
 
 private:
+  [[nodiscard]] juce::Rectangle<float> playHeadBounds() const {
+    return {playHeadPosition, 0.0f, PianoRollTheme::vBarSeparatorWidth / scaledWidth * 0.5f, static_cast<float>(getHeight())};
+  }
+
   float scaledWidth{1.0f};
   float scaledHeight{1.0f};
+  TileCache m_background{[this](juce::Graphics &g, const juce::Rectangle<int> &area) { paintBackground(g, area); }};
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TimelineComponent)
 };
\ No newline at end of file
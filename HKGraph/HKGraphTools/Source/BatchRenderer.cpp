@@ -0,0 +1,123 @@
+#include "BatchRenderer.h"
+
+struct BatchRenderer::Worker : public juce::ThreadPoolJob {
+  BatchRenderer &batch;
+
+  Worker(BatchRenderer &owner, int index)
+    : juce::ThreadPoolJob("batch-worker-" + juce::String(index)), batch(owner) {}
+
+  // rebuilds the graph from the preset, so nothing sounding or queued by the previous file
+  // leaks into the next one and every file renders the same whichever worker picks it up
+  void restore(AudioPluginAudioProcessor &processor) {
+    processor.setStateInformation(batch.preset.getData(), static_cast<int>(batch.preset.getSize()));
+    // every worker already runs on its own core, spawning a thread per dispatch only adds overhead
+    processor.graph->async = false;
+    processor.prepareToPlay(batch.settings.render.sampleRate, batch.settings.render.samplesPerBlock);
+  }
+
+  JobStatus runJob() override {
+    AudioPluginAudioProcessor processor;
+
+    while (!shouldExit()) {
+      auto file = batch.nextFile();
+      if (!file.has_value()) break;
+      restore(processor);
+      if (batch.renderFile(processor, file.value())) {
+        ++batch.filesRendered;
+      } else {
+        ++batch.filesFailed;
+      }
+    }
+
+    processor.releaseResources();
+    return jobHasFinished;
+  }
+};
+
+BatchRenderer::BatchRenderer(const BatchSettings &batchSettings)
+  : settings(batchSettings),
+    preset(loadPreset(batchSettings.preset)),
+    files(batchSettings.inputDirectory, true, "*.mid;*.midi", juce::File::findFiles) {
+}
+
+juce::MemoryBlock BatchRenderer::loadPreset(const juce::File &file) {
+  juce::MemoryBlock block;
+  file.loadFileAsData(block);
+  // presets may also be hand-written as XML, convert those to the binary state the plugin stores
+  if (block.getSize() > 0 && static_cast<const char *>(block.getData())[0] == '<') {
+    auto tree = juce::ValueTree::fromXml(block.toString());
+    block.reset();
+    juce::MemoryOutputStream out{block, false};
+    tree.writeToStream(out);
+  }
+  return block;
+}
+
+int BatchRenderer::run() {
+  auto numThreads = std::max(1, settings.numThreads);
+  settings.outputDirectory.createDirectory();
+
+  auto start = juce::Time::getMillisecondCounterHiRes();
+  {
+    juce::ThreadPool pool(numThreads);
+    for (auto i = 0; i < numThreads; ++i) {
+      pool.addJob(new Worker(*this, i), true);
+    }
+    while (pool.getNumJobs() > 0) {
+      juce::Thread::sleep(1000);
+      printProgress((juce::Time::getMillisecondCounterHiRes() - start) / 1000.0);
+    }
+  }
+  auto elapsed = (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+
+  printProgress(elapsed);
+  std::cout
+    << "done in " << elapsed << "s, "
+    << numThreads << " workers, "
+    << static_cast<double>(inputEvents.load()) / std::max(elapsed, 0.001) << " events/sec"
+    << std::endl;
+  return static_cast<int>(filesFailed.load());
+}
+
+std::optional<juce::File> BatchRenderer::nextFile() {
+  std::lock_guard<std::mutex> lock(filesMutex);
+  if (filesExhausted || files == juce::RangedDirectoryIterator()) {
+    filesExhausted = true;
+    return std::nullopt;
+  }
+  auto file = files->getFile();
+  ++files;
+  return file;
+}
+
+bool BatchRenderer::renderFile(AudioPluginAudioProcessor &processor, const juce::File &file) {
+  juce::FileInputStream in(file);
+  juce::MidiFile input;
+  if (!in.openedOk() || !input.readFrom(in)) {
+    std::cerr << "cannot read " << file.getFullPathName() << std::endl;
+    return false;
+  }
+
+  auto result = OfflineRenderer::render(processor, input, settings.render);
+  inputEvents += result.inputEvents;
+  outputEvents += result.outputEvents;
+
+  // mirror the input directory layout, results are written as soon as each file is done
+  auto target = settings.outputDirectory.getChildFile(file.getRelativePathFrom(settings.inputDirectory));
+  target.getParentDirectory().createDirectory();
+  target.deleteFile();
+  juce::FileOutputStream out(target);
+  if (!out.openedOk() || !result.output.writeTo(out)) {
+    std::cerr << "cannot write " << target.getFullPathName() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void BatchRenderer::printProgress(double elapsedSeconds) const {
+  std::cout
+    << "[" << elapsedSeconds << "s] "
+    << "files: " << filesRendered.load() << " rendered, " << filesFailed.load() << " failed, "
+    << "events: " << inputEvents.load() << " in, " << outputEvents.load() << " out"
+    << std::endl;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "OfflineRenderer.h"
+
+struct BatchSettings {
+  juce::File preset;
+  juce::File inputDirectory;
+  juce::File outputDirectory;
+  int numThreads{1};
+  RenderSettings render;
+};
+
+// Renders every MIDI file found under the input directory through the same graph preset.
+// Each worker owns an independent processor, restored from the preset before every file, and
+// pulls the next file from a shared directory iterator, so memory is bounded by the number of
+// workers rather than the size of the corpus.
+class BatchRenderer {
+public:
+  explicit BatchRenderer(const BatchSettings &batchSettings);
+
+  ~BatchRenderer() = default;
+
+  // returns the number of files that failed to render
+  int run();
+
+  static juce::MemoryBlock loadPreset(const juce::File &file);
+
+private:
+  struct Worker;
+
+  std::optional<juce::File> nextFile();
+
+  bool renderFile(AudioPluginAudioProcessor &processor, const juce::File &file);
+
+  void printProgress(double elapsedSeconds) const;
+
+  BatchSettings settings;
+  juce::MemoryBlock preset;
+
+  std::mutex filesMutex;
+  juce::RangedDirectoryIterator files;
+  bool filesExhausted{false};
+
+  std::atomic<std::int64_t> filesRendered{0};
+  std::atomic<std::int64_t> filesFailed{0};
+  std::atomic<std::int64_t> inputEvents{0};
+  std::atomic<std::int64_t> outputEvents{0};
+
+  JUCE_DECLARE_NON_COPYABLE(BatchRenderer)
+};
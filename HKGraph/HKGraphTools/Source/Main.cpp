@@ -0,0 +1,97 @@
+#include "JuceHeader.h"
+#include "BatchRenderer.h"
+#include "ReplayHarness.h"
+#include "SoakHarness.h"
+
+static RenderSettings renderSettings(const juce::ArgumentList &args) {
+  RenderSettings settings;
+  if (args.containsOption("--sample-rate"))
+    settings.sampleRate = args.getValueForOption("--sample-rate").getDoubleValue();
+  if (args.containsOption("--block-size"))
+    settings.samplesPerBlock = args.getValueForOption("--block-size").getIntValue();
+  if (settings.sampleRate <= 0.0 || settings.samplesPerBlock <= 0)
+    juce::ConsoleApplication::fail("invalid sample rate or block size");
+  return settings;
+}
+
+static void batch(const juce::ArgumentList &args) {
+  BatchSettings settings;
+  settings.preset = args.getExistingFileForOption("--preset");
+  settings.inputDirectory = args.getExistingFolderForOption("--input");
+  settings.outputDirectory = args.getFileForOption("--output");
+  settings.numThreads = juce::SystemStats::getNumCpus();
+  if (args.containsOption("--threads"))
+    settings.numThreads = args.getValueForOption("--threads").getIntValue();
+  settings.render = renderSettings(args);
+
+  BatchRenderer renderer(settings);
+  auto failed = renderer.run();
+  if (failed != 0)
+    juce::ConsoleApplication::fail(juce::String(failed) + " file(s) failed to render");
+}
+
+static void replay(const juce::ArgumentList &args) {
+  ReplaySettings settings;
+  settings.capture = args.getExistingFileForOption("--capture");
+  if (args.containsOption("--repeat"))
+    settings.repeat = args.getValueForOption("--repeat").getIntValue();
+
+  ReplayHarness harness(settings);
+  if (!harness.run())
+    juce::ConsoleApplication::fail("replay failed");
+}
+
+static void soak(const juce::ArgumentList &args) {
+  SoakSettings settings;
+  settings.render = renderSettings(args);
+  if (args.containsOption("--preset"))
+    settings.preset = args.getExistingFileForOption("--preset");
+  if (args.containsOption("--duration"))
+    settings.durationSeconds = args.getValueForOption("--duration").getDoubleValue();
+  if (args.containsOption("--mutations-per-second"))
+    settings.mutationsPerSecond = args.getValueForOption("--mutations-per-second").getDoubleValue();
+  if (args.containsOption("--max-p999"))
+    settings.maxP999Micros = args.getValueForOption("--max-p999").getDoubleValue();
+  if (args.containsOption("--max-nodes"))
+    settings.maxNodes = args.getValueForOption("--max-nodes").getIntValue();
+  if (args.containsOption("--seed"))
+    settings.seed = args.getValueForOption("--seed").getLargeIntValue();
+
+  SoakHarness harness(settings);
+  if (!harness.run())
+    juce::ConsoleApplication::fail("p99.9 latency above threshold");
+}
+
+int main(int argc, char *argv[]) {
+  juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+  juce::ConsoleApplication app;
+  app.addHelpCommand("--help|-h", "Usage:", true);
+  app.addCommand({
+    "--batch",
+    "--batch --preset <file> --input <dir> --output <dir> [--threads n] [--sample-rate sr] [--block-size n]",
+    "Renders every MIDI file under a directory through a graph preset.",
+    "The preset is the plugin state, either binary as stored by a host or as XML. "
+    "Files are distributed across a pool of workers, each owning its own copy of the graph.",
+    batch
+  });
+  app.addCommand({
+    "--replay",
+    "--replay --capture <file> [--repeat n]",
+    "Replays a block capture recorded by the plugin and reports processBlock timings.",
+    "A capture is started from the graph editor's popup menu. The graph is rebuilt from the "
+    "snapshots in the capture and fed the exact blocks the host sent, without any audio device.",
+    replay
+  });
+  app.addCommand({
+    "--soak",
+    "--soak [--duration s] [--mutations-per-second n] [--max-p999 us] [--max-nodes n] [--seed n] [--preset <file>] "
+    "[--sample-rate sr] [--block-size n]",
+    "Runs the processor in real time while another thread keeps editing the graph.",
+    "Blocks are processed at the block rate on a high priority thread, while random nodes and edges are "
+    "added, removed and muted through the same calls the graph view makes. Reports block latency "
+    "percentiles and the worst stall, and fails if p99.9 exceeds --max-p999 (default: the block duration).",
+    soak
+  });
+  return app.findAndRunCommand(argc, argv);
+}
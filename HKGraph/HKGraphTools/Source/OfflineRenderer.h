@@ -0,0 +1,80 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "PluginProcessor.h"
+
+struct RenderSettings {
+  double sampleRate{48000.0};
+  int samplesPerBlock{512};
+};
+
+struct RenderResult {
+  juce::MidiFile output;
+  std::int64_t inputEvents{0};
+  std::int64_t outputEvents{0};
+};
+
+// Streams a MIDI file through a prepared processor, block by block, exactly like a host would.
+// The output is written with a millisecond SMPTE time format so no tempo map is needed.
+struct OfflineRenderer {
+
+  static constexpr int ticksPerFrame = 40;
+  static constexpr int framesPerSecond = 25; // 25 * 40 = 1000 ticks per second
+
+  static RenderResult render(AudioPluginAudioProcessor &processor,
+                             const juce::MidiFile &input,
+                             const RenderSettings &settings) {
+    // flatten all the tracks into a single sequence, with timestamps in seconds
+    juce::MidiFile file(input);
+    file.convertTimestampTicksToSeconds();
+    juce::MidiMessageSequence sequence;
+    for (auto t = 0; t < file.getNumTracks(); ++t) {
+      sequence.addSequence(*file.getTrack(t), 0.0);
+    }
+    sequence.updateMatchedPairs();
+
+    RenderResult result;
+    juce::MidiMessageSequence rendered;
+    juce::AudioBuffer<float> audio(2, settings.samplesPerBlock);
+    juce::MidiBuffer midi;
+
+    auto blockSize = static_cast<std::int64_t>(settings.samplesPerBlock);
+    auto lastSample = static_cast<std::int64_t>(sequence.getEndTime() * settings.sampleRate);
+    // one extra block lets the graph flush anything it emits in response to the last events
+    auto numBlocks = lastSample / blockSize + 2;
+
+    auto next = 0;
+    auto numEvents = sequence.getNumEvents();
+    for (std::int64_t block = 0; block < numBlocks; ++block) {
+      auto blockStart = block * blockSize;
+      auto blockEnd = blockStart + blockSize;
+      midi.clear();
+      while (next < numEvents) {
+        const auto &message = sequence.getEventPointer(next)->message;
+        auto position = static_cast<std::int64_t>(message.getTimeStamp() * settings.sampleRate);
+        if (position >= blockEnd) break;
+        if (!message.isMetaEvent()) {
+          midi.addEvent(message, static_cast<int>(std::max<std::int64_t>(0, position - blockStart)));
+          ++result.inputEvents;
+        }
+        ++next;
+      }
+
+      audio.clear();
+      processor.processBlock(audio, midi);
+
+      for (auto m: midi) {
+        auto message = m.getMessage();
+        auto seconds = static_cast<double>(blockStart + m.samplePosition) / settings.sampleRate;
+        message.setTimeStamp(seconds * framesPerSecond * ticksPerFrame);
+        rendered.addEvent(message);
+        ++result.outputEvents;
+      }
+    }
+
+    rendered.updateMatchedPairs();
+    result.output.setSmpteTimeFormat(framesPerSecond, ticksPerFrame);
+    result.output.addTrack(rendered);
+    return result;
+  }
+};
@@ -0,0 +1,79 @@
+#include <numeric>
+#include "ReplayHarness.h"
+
+ReplayHarness::ReplayHarness(const ReplaySettings &replaySettings) : settings(replaySettings) {
+}
+
+bool ReplayHarness::run() {
+  std::vector<double> blockTimes;
+  for (auto i = 0; i < std::max(1, settings.repeat); ++i) {
+    if (!replayOnce(blockTimes)) {
+      return false;
+    }
+  }
+
+  if (blockTimes.empty()) {
+    std::cout << "no blocks in capture" << std::endl;
+    return true;
+  }
+
+  auto total = std::accumulate(blockTimes.begin(), blockTimes.end(), 0.0);
+  std::sort(blockTimes.begin(), blockTimes.end());
+  auto percentile = [&](double p) {
+    auto index = static_cast<size_t>(p * static_cast<double>(blockTimes.size() - 1));
+    return blockTimes[index];
+  };
+  std::cout
+    << "blocks: " << blockTimes.size() << ", "
+    << "total: " << total * 1000.0 << "ms, "
+    << "mean: " << total / static_cast<double>(blockTimes.size()) * 1e6 << "us, "
+    << "p50: " << percentile(0.5) * 1e6 << "us, "
+    << "p99: " << percentile(0.99) * 1e6 << "us, "
+    << "max: " << blockTimes.back() * 1e6 << "us"
+    << std::endl;
+  return true;
+}
+
+bool ReplayHarness::replayOnce(std::vector<double> &blockTimes) {
+  CaptureReader reader(settings.capture);
+  if (!reader.isValid()) {
+    std::cerr << "not a capture file: " << settings.capture.getFullPathName() << std::endl;
+    return false;
+  }
+
+  AudioPluginAudioProcessor processor;
+  juce::AudioBuffer<float> audio;
+  juce::MidiBuffer midi;
+  CaptureChunk chunk;
+  auto prepared = false;
+  auto ticksPerSecond = static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+
+  while (reader.next(chunk)) {
+    if (chunk.type == BlockCapture::ChunkType::Topology) {
+      // restore the graph as it was right after the change, then raise the same event the host session saw
+      processor.setStateInformation(chunk.state.getData(), static_cast<int>(chunk.state.getSize()));
+      if (chunk.event != BlockCapture::fullState) {
+        processor.graph->notify_listeners(static_cast<Graph::Event>(chunk.event));
+      }
+      prepared = false;
+    } else if (chunk.type == BlockCapture::ChunkType::Block) {
+      if (!prepared ||
+          chunk.sampleRate != processor.getSampleRate() ||
+          chunk.numSamples > processor.getBlockSize()) {
+        processor.setRateAndBufferSizeDetails(chunk.sampleRate, chunk.numSamples);
+        processor.prepareToPlay(chunk.sampleRate, chunk.numSamples);
+        prepared = true;
+      }
+      audio.setSize(2, chunk.numSamples, false, false, true);
+      audio.clear();
+      midi.swapWith(chunk.midi);
+
+      auto start = juce::Time::getHighResolutionTicks();
+      processor.processBlock(audio, midi);
+      auto end = juce::Time::getHighResolutionTicks();
+      blockTimes.push_back(static_cast<double>(end - start) / ticksPerSecond);
+    }
+  }
+  processor.releaseResources();
+  return true;
+}
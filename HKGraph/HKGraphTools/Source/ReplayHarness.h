@@ -0,0 +1,29 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "PluginProcessor.h"
+
+struct ReplaySettings {
+  juce::File capture;
+  int repeat{1};
+};
+
+// Re-runs a capture recorded by the plugin, block by block, against a fresh processor.
+// Runs headless so it can be wrapped by profilers and instrumentation tools, and reports
+// the time spent in `processBlock`.
+class ReplayHarness {
+public:
+  explicit ReplayHarness(const ReplaySettings &replaySettings);
+
+  ~ReplayHarness() = default;
+
+  // returns false if the capture cannot be read
+  bool run();
+
+private:
+  bool replayOnce(std::vector<double> &blockTimes);
+
+  ReplaySettings settings;
+
+  JUCE_DECLARE_NON_COPYABLE(ReplayHarness)
+};
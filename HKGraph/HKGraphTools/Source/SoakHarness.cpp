@@ -0,0 +1,205 @@
+#include "SoakHarness.h"
+#include "BatchRenderer.h"
+
+struct SoakHarness::AudioThread : public juce::Thread {
+  SoakHarness &soak;
+  AudioPluginAudioProcessor &processor;
+
+  AudioThread(SoakHarness &owner, AudioPluginAudioProcessor &p)
+    : juce::Thread("soak-audio"), soak(owner), processor(p) {}
+
+  void run() override {
+    auto const &render = soak.settings.render;
+    juce::AudioBuffer<float> audio(2, render.samplesPerBlock);
+    juce::MidiBuffer midi;
+    juce::Random random(soak.settings.seed);
+    std::vector<std::pair<int, int>> held;
+    held.reserve(128);
+
+    auto period = std::chrono::nanoseconds(
+      static_cast<std::int64_t>(render.samplesPerBlock * 1.0e9 / render.sampleRate));
+    auto next = std::chrono::steady_clock::now();
+
+    while (!threadShouldExit()) {
+      midi.clear();
+      // keep a few notes going so every node on the path has work to do
+      if (held.size() < 16 && random.nextInt(4) == 0) {
+        auto channel = random.nextInt(16) + 1;
+        auto note = random.nextInt(128);
+        midi.addEvent(juce::MidiMessage::noteOn(channel, note, static_cast<juce::uint8>(random.nextInt({1, 128}))),
+                      random.nextInt(render.samplesPerBlock));
+        held.emplace_back(channel, note);
+      }
+      if (!held.empty() && random.nextInt(4) == 0) {
+        auto index = static_cast<size_t>(random.nextInt(static_cast<int>(held.size())));
+        midi.addEvent(juce::MidiMessage::noteOff(held[index].first, held[index].second),
+                      random.nextInt(render.samplesPerBlock));
+        held[index] = held.back();
+        held.pop_back();
+      }
+      if (random.nextInt(8) == 0) {
+        midi.addEvent(juce::MidiMessage::controllerEvent(random.nextInt(16) + 1, 1, random.nextInt(128)), 0);
+      }
+
+      processor.processBlock(audio, midi);
+      ++soak.blocks;
+
+      // a host calls back once per block period, if a block overran the next one starts right away
+      next += period;
+      auto now = std::chrono::steady_clock::now();
+      if (now > next) {
+        ++soak.lateBlocks;
+        next = now;
+      } else {
+        std::this_thread::sleep_until(next);
+      }
+    }
+  }
+};
+
+struct SoakHarness::Mutator : public juce::Thread {
+  struct Entry {
+    uuid id;
+    int rank;
+  };
+
+  SoakHarness &soak;
+  AudioPluginAudioProcessor &processor;
+  juce::Random random;
+  // nodes only connect to nodes of a higher rank, which keeps the graph acyclic
+  std::vector<Entry> entries;
+  int nextRank{1};
+
+  Mutator(SoakHarness &owner, AudioPluginAudioProcessor &p)
+    : juce::Thread("soak-mutator"), soak(owner), processor(p), random(owner.settings.seed + 1) {
+    entries.push_back({processor.midiIn->m_id, 0});
+    entries.push_back({processor.midiOut->m_id, std::numeric_limits<int>::max()});
+  }
+
+  void run() override {
+    auto interval = static_cast<int>(1000.0 / std::max(soak.settings.mutationsPerSecond, 0.001));
+    while (!threadShouldExit()) {
+      mutate();
+      ++soak.mutations;
+      wait(std::max(1, interval));
+    }
+  }
+
+  void mutate() {
+    auto graph = processor.graph;
+    auto added = static_cast<int>(entries.size()) - 2;
+    auto op = random.nextInt(100);
+    if (op < 30 && added < soak.settings.maxNodes) {
+      auto node = makeNode(graph);
+      graph->add_node(node);
+      entries.push_back({node->m_id, nextRank++});
+    } else if (op < 60) {
+      auto &source = entries[static_cast<size_t>(random.nextInt(static_cast<int>(entries.size())))];
+      auto &target = entries[static_cast<size_t>(random.nextInt(static_cast<int>(entries.size())))];
+      if (source.rank < target.rank) {
+        auto sourcePin = randomPin(graph->m_nodes[source.id]->m_outs);
+        auto targetPin = randomPin(graph->m_nodes[target.id]->m_ins);
+        if (sourcePin.has_value() && targetPin.has_value()) {
+          graph->connect(sourcePin.value(), targetPin.value());
+        }
+      }
+    } else if (op < 80) {
+      if (!graph->m_edges.empty()) {
+        auto itr = std::next(graph->m_edges.begin(), random.nextInt(static_cast<int>(graph->m_edges.size())));
+        graph->disconnect(itr->first);
+      }
+    } else if (op < 92 || added >= soak.settings.maxNodes) {
+      if (added > 0) {
+        auto index = static_cast<size_t>(2 + random.nextInt(added));
+        graph->remove_node(entries[index].id);
+        entries.erase(entries.begin() + static_cast<std::ptrdiff_t>(index));
+      }
+    } else if (added > 0) {
+      auto index = static_cast<size_t>(2 + random.nextInt(added));
+      graph->m_nodes[entries[index].id]->toggle_muted(graph);
+    }
+  }
+
+  std::optional<uuid> randomPin(const std::unordered_map<uuid, Graph::Node::Pin> &pins) {
+    if (pins.empty()) return std::nullopt;
+    return std::next(pins.begin(), random.nextInt(static_cast<int>(pins.size())))->first;
+  }
+
+  NodeProcessor *makeNode(Graph *graph) {
+    switch (random.nextInt(7)) {
+      case 0:
+        return new TransposeProcessor(graph, "transpose", 1, 1);
+      case 1:
+        return new ChannelSplitterProcessor(graph, "channel-splitter", 1, 16);
+      case 2:
+        return new ChannelRouterProcessor(graph, "channel-router", 1, 1);
+      case 3:
+        return new ChordSplitterProcessor(graph, "chord-splitter", 1, 16);
+      case 4:
+        return new NoteFilterProcessor(graph, "note-filter", 1, 1);
+      case 5:
+        return new VelocityCurveProcessor(graph, "velocity-curve", 1, 1);
+      default:
+        return new ControllerCurveProcessor(graph, "cc-curve", 1, 1);
+    }
+  }
+};
+
+SoakHarness::SoakHarness(const SoakSettings &soakSettings) : settings(soakSettings) {
+}
+
+bool SoakHarness::run() {
+  AudioPluginAudioProcessor processor;
+  if (settings.preset.has_value()) {
+    auto preset = BatchRenderer::loadPreset(settings.preset.value());
+    processor.setStateInformation(preset.getData(), static_cast<int>(preset.getSize()));
+  }
+  processor.setRateAndBufferSizeDetails(settings.render.sampleRate, settings.render.samplesPerBlock);
+  processor.prepareToPlay(settings.render.sampleRate, settings.render.samplesPerBlock);
+  processor.resetTelemetry();
+
+  auto start = juce::Time::getMillisecondCounterHiRes();
+  {
+    AudioThread audio(*this, processor);
+    Mutator mutator(*this, processor);
+    audio.startThread(juce::Thread::Priority::highest);
+    mutator.startThread();
+
+    auto elapsed = 0.0;
+    while (elapsed < settings.durationSeconds) {
+      juce::Thread::sleep(static_cast<int>(std::min(10.0, settings.durationSeconds - elapsed) * 1000.0) + 1);
+      elapsed = (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+      printProgress(processor, elapsed);
+    }
+
+    mutator.stopThread(5000);
+    audio.stopThread(5000);
+  }
+  processor.releaseResources();
+
+  auto const &blockTime = processor.telemetry.blockTime;
+  auto p999 = static_cast<double>(blockTime.percentile(0.999)) / 1000.0;
+  auto threshold = settings.maxP999Micros > 0.0
+                   ? settings.maxP999Micros
+                   : settings.render.samplesPerBlock * 1.0e6 / settings.render.sampleRate;
+  auto snapshot = processor.telemetrySnapshot();
+  std::cout
+    << "blocks: " << blocks.load() << ", late: " << lateBlocks.load() << ", "
+    << "mutations: " << mutations.load() << ", "
+    << "p50: " << snapshot.p50 << "us, p99: " << snapshot.p99 << "us, p99.9: " << p999 << "us, "
+    << "worst stall: " << snapshot.max << "us, "
+    << "over deadline: " << snapshot.over100 << ", "
+    << "threshold: " << threshold << "us"
+    << std::endl;
+  return p999 <= threshold;
+}
+
+void SoakHarness::printProgress(AudioPluginAudioProcessor &processor, double elapsedSeconds) const {
+  auto snapshot = processor.telemetry.snapshot();
+  std::cout
+    << "[" << elapsedSeconds << "s] "
+    << "blocks: " << blocks.load() << ", late: " << lateBlocks.load() << ", "
+    << "mutations: " << mutations.load() << ", "
+    << "p99: " << snapshot.p99 << "us, max: " << snapshot.max << "us"
+    << std::endl;
+}
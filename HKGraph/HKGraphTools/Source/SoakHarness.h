@@ -0,0 +1,45 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "OfflineRenderer.h"
+
+struct SoakSettings {
+  RenderSettings render;
+  std::optional<juce::File> preset;
+  double durationSeconds{60.0};
+  double mutationsPerSecond{50.0};
+  // fail threshold for the 99.9th percentile of processBlock, 0 uses the block duration
+  double maxP999Micros{0.0};
+  int maxNodes{24};
+  juce::int64 seed{1};
+};
+
+// Runs the processor in real time on one thread while another thread keeps editing the graph
+// through the same calls the graph view makes (add_node, connect, disconnect, remove_node, mute),
+// so the audio thread contends for the graph lock the way it does in a live session.
+//
+// Block timings come from the processor's own telemetry, the run fails when the 99.9th percentile
+// exceeds the threshold.
+class SoakHarness {
+public:
+  explicit SoakHarness(const SoakSettings &soakSettings);
+
+  ~SoakHarness() = default;
+
+  // returns false if the latency threshold is exceeded
+  bool run();
+
+private:
+  struct AudioThread;
+  struct Mutator;
+
+  void printProgress(AudioPluginAudioProcessor &processor, double elapsedSeconds) const;
+
+  SoakSettings settings;
+
+  std::atomic<std::int64_t> blocks{0};
+  std::atomic<std::int64_t> lateBlocks{0};
+  std::atomic<std::int64_t> mutations{0};
+
+  JUCE_DECLARE_NON_COPYABLE(SoakHarness)
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+// A single value published by a processor and shown by its editor.
+//
+// The writer (usually the audio thread) stores the latest value and bumps a sequence number, it never
+// blocks, allocates or touches a component. Readers poll from the message thread at a bounded rate
+// and only ever see the most recent value, intermediate ones are dropped.
+template<typename T>
+struct TelemetrySlot {
+  static_assert(std::atomic<T>::is_always_lock_free, "TelemetrySlot needs a lock-free value type");
+
+  TelemetrySlot() = default;
+
+  explicit TelemetrySlot(T initial) : m_value(initial) {}
+
+  void write(T value) {
+    m_value.store(value, std::memory_order_relaxed);
+    m_sequence.fetch_add(1, std::memory_order_release);
+  }
+
+  [[nodiscard]] T read() const {
+    return m_value.load(std::memory_order_relaxed);
+  }
+
+  // returns true and the latest value if anything was written since `lastSequence`
+  bool readIfChanged(T &value, std::uint32_t &lastSequence) const {
+    auto sequence = m_sequence.load(std::memory_order_acquire);
+    if (sequence == lastSequence) return false;
+    lastSequence = sequence;
+    value = m_value.load(std::memory_order_relaxed);
+    return true;
+  }
+
+private:
+  std::atomic<T> m_value{};
+  std::atomic<std::uint32_t> m_sequence{0};
+
+  JUCE_DECLARE_NON_COPYABLE(TelemetrySlot)
+};
+
+// One timer for every telemetry reader in the process, shared through a SharedResourcePointer.
+struct TelemetryPoller : private juce::Timer {
+  static constexpr int RATE_HZ = 30;
+
+  struct Client {
+    virtual ~Client() = default;
+
+    virtual void poll() = 0;
+  };
+
+  TelemetryPoller() {
+    startTimerHz(RATE_HZ);
+  }
+
+  ~TelemetryPoller() override {
+    stopTimer();
+  }
+
+  void add(Client *client) {
+    m_clients.add(client);
+  }
+
+  void remove(Client *client) {
+    m_clients.remove(client);
+  }
+
+private:
+  void timerCallback() override {
+    m_clients.call([](Client &c) { c.poll(); });
+  }
+
+  juce::ListenerList<Client> m_clients;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TelemetryPoller)
+};
+
+// Follows a slot on the message thread and calls `onChange` with the latest value, at most
+// TelemetryPoller::RATE_HZ times per second.
+template<typename T>
+struct TelemetryReader : private TelemetryPoller::Client {
+  std::function<void(T)> onChange;
+
+  explicit TelemetryReader(const TelemetrySlot<T> &slot) : m_slot(slot) {
+    m_poller->add(this);
+  }
+
+  ~TelemetryReader() override {
+    m_poller->remove(this);
+  }
+
+private:
+  void poll() override {
+    T value;
+    if (m_slot.readIfChanged(value, m_sequence) && onChange != nullptr) {
+      onChange(value);
+    }
+  }
+
+  const TelemetrySlot<T> &m_slot;
+  std::uint32_t m_sequence{0};
+  juce::SharedResourcePointer<TelemetryPoller> m_poller;
+
+  JUCE_DECLARE_NON_COPYABLE(TelemetryReader)
+};